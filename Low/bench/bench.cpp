@@ -0,0 +1,627 @@
+/**
+ * @file bench.cpp
+ * 
+ * @brief Benchmarks for loading and dropping deserialized models.
+ * 
+ * Usage: finapi_bench [--json] [--runs n] [tag count ...]
+ * 
+ * Every tag count gets its own synthetic DataTag file, 20000 tags if none are given. Each
+ * case is run n times and the fastest load and drop are kept. With --json every result is
+ * printed as one JSON object per line instead of a table, for comparing releases.
+ * 
+ * @author  Max Ortner
+ * @date    2020-01-10
+ * @version 0.1
+ * 
+ * @copyright Copyright (c) 2020
+ * 
+ */
+
+#include "finapi/finapi.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <random>
+#include <cmath>
+
+using namespace finapi;
+
+/* ------------ ALLOCATION COUNTING ------------ */
+#ifdef __GLIBC__
+
+extern "C" void* __libc_malloc(std::size_t);
+extern "C" void* __libc_calloc(std::size_t, std::size_t);
+extern "C" void* __libc_realloc(void*, std::size_t);
+extern "C" void  __libc_free(void*);
+
+static std::atomic<unsigned long> allocations(0);
+static std::atomic<unsigned long> frees(0);
+
+extern "C" void* malloc(std::size_t size)               { allocations++; return __libc_malloc(size); }
+extern "C" void* calloc(std::size_t n, std::size_t size) { allocations++; return __libc_calloc(n, size); }
+extern "C" void* realloc(void* ptr, std::size_t size)   { allocations++; return __libc_realloc(ptr, size); }
+extern "C" void  free(void* ptr)                        { if (ptr) frees++; __libc_free(ptr); }
+
+#   define _BENCH_COUNTS
+
+#endif
+/* --------------------------------------------- */
+
+namespace bench
+{
+    typedef std::chrono::steady_clock clock;
+
+    static double ms_since(const clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    }
+
+    static void write_u32(std::string& out, c_uint value)
+        { out.append((const char*)&value, sizeof(value)); }
+
+    static void write_string(std::string& out, const std::string& str)
+        { write_u32(out, str.size()); out += str; }
+
+    /**
+     * @brief Builds a DataTag file in memory with values resembling a real filing.
+     */
+    static std::string make_tags(c_uint count, c_uint seed = 42)
+    {
+        static const char* balances[] = { "debit", "credit" };
+        static const char* factors[]  = { "1", "1000", "1000000" };
+        static const char* units[]    = { "USD", "shares", "USD/shares", "pure" };
+        static const char* words[]    = { "Revenues", "Cost", "Operating", "Income", "Expense", "Assets",
+                                          "Liabilities", "Equity", "Net", "Tax", "Deferred", "Current" };
+
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> word(0, 11);
+
+        // Most labels are a few words long with a long tail of very descriptive ones
+        std::geometric_distribution<int> extra_words(0.35);
+
+        auto concept = [&](const int words_in_tag)
+        {
+            std::string r = "us-gaap_";
+            for (int i = 0; i < words_in_tag; i++) r += words[word(rng)];
+            return r;
+        };
+
+        // Tags and parents come out of a fixed taxonomy, like real filings do
+        std::vector<std::string> taxonomy;
+        for (int i = 0; i < 2000; i++)
+            taxonomy.push_back(concept(2 + rng() % 4));
+
+        std::string out;
+        write_u32(out, DATA_TAG_MN);
+        write_u32(out, count);
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            const std::string fields[] = {
+                balances[rng() % 2],
+                factors[rng() % 3],
+                "fact-" + std::to_string(rng()) + "-" + std::to_string(i),
+                concept(2 + std::min(extra_words(rng), 24)) + (rng() % 3 ? " for the period" : ""),
+                taxonomy[rng() % 200],
+                taxonomy[rng() % taxonomy.size()],
+                units[rng() % 4]
+            };
+
+            for (int j = 0; j < 7; j++)
+            {
+                if (j == 5)
+                {
+                    const int sequence = i;
+                    out.append((const char*)&sequence, sizeof(int));
+                }
+
+                // Every DataTag string is preceded by an extra length word
+                write_u32(out, fields[j].size());
+                write_string(out, fields[j]);
+            }
+
+            const float value = (float)(rng() % 1000000) / 100.f;
+            out.append((const char*)&value, sizeof(float));
+        }
+
+        return out;
+    }
+
+    static Cloud::File* to_file(const std::string& data)
+    {
+        Cloud::File* file = new Cloud::File((unsigned int)data.size());
+        std::memcpy(file->buffer, data.data(), data.size());
+        return file;
+    }
+
+    struct result
+    {
+        double        load_ms;
+        double        drop_ms;
+        unsigned long allocations;
+        unsigned long frees;
+    };
+
+    /**
+     * @brief What is being measured and how it is printed.
+     */
+    struct settings
+    {
+        bool         json = false;
+        unsigned int runs = 1;
+    };
+
+    static settings config;
+
+    /**
+     * @brief Size of the corpus the results belong to.
+     */
+    struct corpus
+    {
+        unsigned int count;
+        std::size_t  bytes;
+    };
+
+    /**
+     * @brief Runs a case the configured amount of times and keeps its fastest load and drop.
+     */
+    template<typename F>
+    static result best_of(F run)
+    {
+        result r = run();
+        for (unsigned int i = 1; i < config.runs; i++)
+        {
+            const result next = run();
+            r.load_ms = std::min(r.load_ms, next.load_ms);
+            r.drop_ms = std::min(r.drop_ms, next.drop_ms);
+        }
+
+        return r;
+    }
+
+    static void report(const char* name, const result& r, const corpus& c)
+    {
+        const double tags_per_s = (r.load_ms > 0 ? c.count / r.load_ms * 1000 : 0);
+        const double mib_per_s  = (r.load_ms > 0 ? c.bytes / r.load_ms * 1000 / (1024 * 1024) : 0);
+        const double drop_ns    = (c.count ? r.drop_ms * 1e6 / c.count : 0);
+        const double per_tag    = (c.count ? (double)r.allocations / c.count : 0);
+
+        if (config.json)
+        {
+            std::cout << std::fixed << std::setprecision(4)
+                      << "{\"case\":\"" << name << "\",\"tags\":" << c.count << ",\"bytes\":" << c.bytes
+                      << ",\"runs\":" << config.runs
+                      << ",\"load_ms\":" << r.load_ms << ",\"drop_ms\":" << r.drop_ms
+                      << ",\"tags_per_s\":" << tags_per_s << ",\"mib_per_s\":" << mib_per_s
+                      << ",\"drop_ns_per_tag\":" << drop_ns
+                      << ",\"allocs\":" << r.allocations << ",\"frees\":" << r.frees
+                      << ",\"allocs_per_tag\":" << per_tag << "}\n";
+            return;
+        }
+
+        std::cout << std::left  << std::setw(10) << name
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << r.load_ms << " ms load"
+                  << std::setw(10) << r.drop_ms << " ms drop"
+                  << std::setw(10) << mib_per_s << " MiB/s"
+                  << std::setw(10) << drop_ns << " ns/drop"
+                  << std::setw(12) << r.allocations << " allocs"
+                  << std::setw(12) << r.frees << " frees"
+                  << std::setw(10) << per_tag << " allocs/tag\n";
+    }
+
+    /**
+     * @brief Prints a result that isn't a load and drop, as a JSON object or a line of text.
+     */
+    static void note(const char* name, const corpus& c, const std::string& json, const std::string& text)
+    {
+        if (config.json)
+            std::cout << "{\"case\":\"" << name << "\",\"tags\":" << c.count << ",\"bytes\":" << c.bytes << "," << json << "}\n";
+        else
+            std::cout << std::left << std::setw(10) << name << text << "\n";
+    }
+
+    /**
+     * @brief Loads and drops the tag file with the regular heap deserializer.
+     */
+    static result heap_tags(const std::string& data)
+    {
+        result r;
+        Cloud::File* file = to_file(data);
+        std::vector<DataTag*> tags;
+
+    #ifdef _BENCH_COUNTS
+        const unsigned long a = allocations, f = frees;
+    #endif
+
+        clock::time_point start = clock::now();
+        deserialize(tags, file);
+        r.load_ms = ms_since(start);
+
+        start = clock::now();
+        clean_list(tags);
+        tags.clear();
+        r.drop_ms = ms_since(start);
+
+    #ifdef _BENCH_COUNTS
+        r.allocations = allocations - a;
+        r.frees       = frees - f;
+    #else
+        r.allocations = r.frees = 0;
+    #endif
+
+        delete file;
+        return r;
+    }
+
+    /**
+     * @brief Loads and drops the tag file with the arena deserializer.
+     */
+    static result arena_tags(const std::string& data)
+    {
+        result r;
+        Cloud::File* file = to_file(data);
+        std::vector<DataTag*> tags;
+        Arena arena;
+
+    #ifdef _BENCH_COUNTS
+        const unsigned long a = allocations, f = frees;
+    #endif
+
+        clock::time_point start = clock::now();
+        deserialize(tags, file, arena);
+        r.load_ms = ms_since(start);
+
+        start = clock::now();
+        arena.release();
+        tags.clear();
+        r.drop_ms = ms_since(start);
+
+    #ifdef _BENCH_COUNTS
+        r.allocations = allocations - a;
+        r.frees       = frees - f;
+    #else
+        r.allocations = r.frees = 0;
+    #endif
+
+        delete file;
+        return r;
+    }
+
+    /**
+     * @brief Scans the tag file for a couple of fields through a view, without materializing it.
+     */
+    static result view_tags(const std::string& data)
+    {
+        result r;
+        Cloud::File* file = to_file(data);
+
+    #ifdef _BENCH_COUNTS
+        const unsigned long a = allocations, f = frees;
+    #endif
+
+        clock::time_point start = clock::now();
+
+        double total = 0;
+        for (DataTagView tag : DataTagListView(file))
+            if (tag.unit() == "USD") total += tag.value();
+
+        r.load_ms = ms_since(start);
+        r.drop_ms = 0;
+
+    #ifdef _BENCH_COUNTS
+        r.allocations = allocations - a;
+        r.frees       = frees - f;
+    #else
+        r.allocations = r.frees = 0;
+    #endif
+
+        // Keep the scan from being optimized away
+        if (total < 0) std::cout << total;
+
+        delete file;
+        return r;
+    }
+
+    /**
+     * @brief Loads the tag file from disk, either through a stream or a memory mapping.
+     */
+    static result disk_tags(const char* path, const bool mapped)
+    {
+        result r;
+        std::vector<DataTag*> tags;
+
+    #ifdef _BENCH_COUNTS
+        const unsigned long a = allocations, f = frees;
+    #endif
+
+        clock::time_point start = clock::now();
+        if (mapped)
+        {
+            MappedFile map(path);
+            ByteSource source = map.source();
+            deserialize(tags, source);
+        }
+        else
+        {
+            std::ifstream file(path, std::ios::binary);
+            deserialize(tags, file);
+        }
+        r.load_ms = ms_since(start);
+
+        start = clock::now();
+        clean_list(tags);
+        tags.clear();
+        r.drop_ms = ms_since(start);
+
+    #ifdef _BENCH_COUNTS
+        r.allocations = allocations - a;
+        r.frees       = frees - f;
+    #else
+        r.allocations = r.frees = 0;
+    #endif
+
+        return r;
+    }
+
+    /**
+     * @brief Loads the tag file with the parallel deserializer on a given amount of threads.
+     */
+    static result parallel_tags(const std::string& data, c_uint threads)
+    {
+        result r;
+        ThreadPool pool(threads);
+        const ByteSource source(data.data(), data.size());
+        std::vector<DataTag*> tags;
+
+    #ifdef _BENCH_COUNTS
+        const unsigned long a = allocations, f = frees;
+    #endif
+
+        clock::time_point start = clock::now();
+        deserialize(tags, source, pool);
+        r.load_ms = ms_since(start);
+
+        start = clock::now();
+        clean_list(tags);
+        tags.clear();
+        r.drop_ms = ms_since(start);
+
+    #ifdef _BENCH_COUNTS
+        r.allocations = allocations - a;
+        r.frees       = frees - f;
+    #else
+        r.allocations = r.frees = 0;
+    #endif
+
+        return r;
+    }
+
+    /**
+     * @brief Re-emits the tags in both layouts and checks they read back to the same bytes.
+     */
+    static void serialize_tags(const std::string& data, const corpus& c)
+    {
+        ByteSource source(data.data(), data.size());
+        std::vector<DataTag*> tags;
+        deserialize(tags, source);
+
+        ByteSink sink;
+
+        clock::time_point start = clock::now();
+        serialize(tags, sink);
+        const double v1_ms = ms_since(start);
+
+        const bool v1_same = (sink.size() == data.size() && !std::memcmp(sink.data(), data.data(), data.size()));
+
+        sink.clear();
+        start = clock::now();
+        serialize(tags, sink, 2);
+        const double v2_ms = ms_since(start);
+
+        // The v2 output has to read back as the same tags
+        std::vector<char> upgraded;
+        format::upgrade_tags(data.data(), data.size(), upgraded);
+        const bool v2_same = (sink.size() == upgraded.size() && !std::memcmp(sink.data(), upgraded.data(), upgraded.size()));
+
+        std::ostringstream json, text;
+        json << std::fixed << std::setprecision(4)
+             << "\"v1_ms\":" << v1_ms << ",\"v2_ms\":" << v2_ms
+             << ",\"tags_per_s\":" << c.count / v1_ms * 1000
+             << ",\"same\":" << (v1_same && v2_same ? "true" : "false");
+        text << std::fixed << std::setprecision(2)
+             << "v1 " << v1_ms << " ms, v2 " << v2_ms << " ms, "
+             << c.count / v1_ms / 1000 << " M tags/s"
+             << (v1_same && v2_same ? "" : "  MISMATCH");
+
+        note("serialize", c, json.str(), text.str());
+
+        clean_list(tags);
+    }
+
+    /**
+     * @brief Writes a Company and a Statement, reads them back and writes them again.
+     */
+    static bool round_trip_models()
+    {
+        Company company;
+        company.cik    = strdup("0000320193");
+        company.id     = strdup("company-1");
+        company.lei    = strdup("HWUPKR0MPOU8FGXBT394");
+        company.name   = strdup("Apple Inc.");
+        company.ticker = strdup("AAPL");
+
+        Statement statement;
+        statement.end_date       = strdup("2019-09-28");
+        statement.filing_date    = strdup("2019-10-31");
+        statement.fiscal_period  = strdup("FY");
+        statement.fiscal_year    = 2019;
+        statement.id             = strdup("statement-1");
+        statement.start_date     = strdup("2018-09-30");
+        statement.statement_code = strdup("BS");
+        statement.type           = strdup("10-K");
+
+        ByteSink first, second;
+        serialize(&company, first);
+        serialize(&statement, first);
+
+        ByteSource source(first.data(), first.size());
+        Company*   company_read   = nullptr;
+        Statement* statement_read = nullptr;
+        deserialize(&company_read, source);
+        deserialize(&statement_read, source);
+
+        serialize(company_read, second);
+        serialize(statement_read, second);
+
+        const bool same = (first.size() == second.size() && !std::memcmp(first.data(), second.data(), first.size()));
+
+        delete company_read;
+        delete statement_read;
+        return same;
+    }
+
+    /**
+     * @brief Loads the tag file into a columnar table.
+     */
+    static result table_tags(const std::string& data, DataTagTable& table)
+    {
+        result r;
+        Cloud::File* file = to_file(data);
+
+    #ifdef _BENCH_COUNTS
+        const unsigned long a = allocations, f = frees;
+    #endif
+
+        clock::time_point start = clock::now();
+        deserialize(table, file);
+        r.load_ms = ms_since(start);
+        r.drop_ms = 0;
+
+    #ifdef _BENCH_COUNTS
+        r.allocations = allocations - a;
+        r.frees       = frees - f;
+    #else
+        r.allocations = r.frees = 0;
+    #endif
+
+        delete file;
+        return r;
+    }
+
+    /**
+     * @brief Compares summing the USD values over the object list against the table kernel.
+     */
+    static void aggregate(const std::string& data, const DataTagTable& table, const corpus& c)
+    {
+        const int RUNS = 100;
+
+        Cloud::File* file = to_file(data);
+        std::vector<DataTag*> tags;
+        deserialize(tags, file);
+        delete file;
+
+        double list_sum = 0, table_sum = 0;
+
+        clock::time_point start = clock::now();
+        for (int run = 0; run < RUNS; run++)
+        {
+            list_sum = 0;
+            for (const DataTag* tag : tags)
+                if (!std::strcmp(tag->unit, "USD")) list_sum += tag->value;
+        }
+        const double list_ms = ms_since(start) / RUNS;
+
+        start = clock::now();
+        for (int run = 0; run < RUNS; run++)
+            table_sum = table.sum(DataTagTable::UNIT, table.code(DataTagTable::UNIT, "USD"));
+        const double table_ms = ms_since(start) / RUNS;
+
+        const bool same = (std::abs(list_sum - table_sum) <= 1e-6 * std::abs(list_sum));
+
+        std::ostringstream json, text;
+        json << std::fixed << std::setprecision(4)
+             << "\"list_ms\":" << list_ms << ",\"table_ms\":" << table_ms
+             << ",\"same\":" << (same ? "true" : "false");
+        text << std::fixed << std::setprecision(4)
+             << "list " << list_ms << " ms, table " << table_ms << " ms"
+             << (same ? "" : "  MISMATCH");
+
+        note("sum(USD)", c, json.str(), text.str());
+
+        clean_list(tags);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<unsigned int> counts;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "--json")
+            bench::config.json = true;
+        else if (arg == "--runs" && i + 1 < argc)
+            bench::config.runs = std::max(1, std::atoi(argv[++i]));
+        else if (std::atoi(argv[i]) > 0)
+            counts.push_back(std::atoi(argv[i]));
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--json] [--runs n] [tag count ...]\n";
+            return 1;
+        }
+    }
+
+    if (counts.empty()) counts.push_back(20000);
+
+    for (const unsigned int count : counts)
+    {
+        const std::string   data = bench::make_tags(count);
+        const bench::corpus c    = { count, data.size() };
+
+        if (!bench::config.json)
+            std::cout << count << " tags, " << data.size() / 1024 << " KiB\n";
+
+        // heap goes through a Cloud::File, like a download would
+        bench::report("heap",  bench::best_of([&]() { return bench::heap_tags(data); }),  c);
+        bench::report("arena", bench::best_of([&]() { return bench::arena_tags(data); }), c);
+        bench::report("view",  bench::best_of([&]() { return bench::view_tags(data); }),  c);
+
+        // The caller decodes a range as well, so n workers means n + 1 threads
+        for (unsigned int threads = 1; threads < std::max(2u, std::thread::hardware_concurrency()); threads *= 2)
+        {
+            const std::string name = "par/" + std::to_string(threads + 1);
+            bench::report(name.c_str(), bench::best_of([&]() { return bench::parallel_tags(data, threads); }), c);
+        }
+
+        bench::serialize_tags(data, c);
+
+        const bool round_trip = bench::round_trip_models();
+        bench::note("models", c, std::string("\"same\":") + (round_trip ? "true" : "false"),
+                    round_trip ? "round trip ok" : "round trip MISMATCH");
+
+        const char* path = "finapi_bench_tags.bin";
+        std::ofstream(path, std::ios::binary).write(data.data(), data.size());
+        bench::report("ifstream", bench::best_of([&]() { return bench::disk_tags(path, false); }), c);
+        bench::report("mmap",     bench::best_of([&]() { return bench::disk_tags(path, true); }),  c);
+        std::remove(path);
+
+        const InternTable::stats interning = interned().statistics();
+        std::ostringstream json, text;
+        json << std::fixed << std::setprecision(4)
+             << "\"strings\":" << interning.strings << ",\"hit_rate\":" << interning.hit_rate()
+             << ",\"bytes_saved\":" << interning.bytes_saved;
+        text << std::fixed << std::setprecision(1)
+             << interning.strings << " strings, " << 100 * interning.hit_rate() << "% hits, "
+             << interning.bytes_saved / 1024 << " KiB saved";
+        bench::note("interned", c, json.str(), text.str());
+
+        DataTagTable table;
+        bench::report("table", bench::best_of([&]() { return bench::table_tags(data, table); }), c);
+        bench::aggregate(data, table, c);
+    }
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file Arena.h
+ *
+ * @brief Bump allocator that owns every object and string of a deserialized document.
+ *
+ * Allocations are carved out of large blocks and are never freed individually. Dropping
+ * the whole document is a matter of freeing the handful of blocks.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-10
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "Core.h"
+
+// Size of the first block, later blocks double in size
+#define _FIN_ARENA_BLOCK 1024*64
+
+namespace finapi
+{
+    class Arena
+    {
+    public:
+        Arena(c_uint block_size = _FIN_ARENA_BLOCK);
+        ~Arena();
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        /**
+         * @brief Allocates raw memory from the current block.
+         *
+         * @param size      Amount of bytes
+         * @param align     Alignment of the memory, must be a power of two
+         * @return void*    Pointer valid until the arena is released
+         */
+        void* allocate(const std::size_t size, const std::size_t align = alignof(std::max_align_t));
+
+        /**
+         * @brief Allocates room for a string of the given length plus its terminator.
+         */
+        char* allocate_string(c_uint length)
+            { return (char*)allocate((std::size_t)length + 1, 1); }
+
+        /**
+         * @brief Constructs an object in the arena.
+         *
+         * The destructor of the object is never run, so it must not own anything
+         * outside of the arena.
+         */
+        template<typename T>
+        T* create()
+            { return new (allocate(sizeof(T), alignof(T))) T; }
+
+        /**
+         * @brief Frees every block, invalidating everything allocated from the arena.
+         */
+        void release();
+
+        /**
+         * @brief Amount of bytes handed out since the last release.
+         */
+        std::size_t used() const;
+
+        /**
+         * @brief Amount of blocks currently held.
+         */
+        unsigned int blocks() const;
+
+    private:
+        struct block
+        {
+            block*      next;
+            std::size_t size;
+        };
+
+        block*       head;
+        char*        cursor;
+        char*        end;
+
+        std::size_t  block_size;
+        std::size_t  next_size;
+        std::size_t  bytes;
+        unsigned int count;
+    };
+}
@@ -0,0 +1,96 @@
+/**
+ * @file ByteSink.h
+ *
+ * @brief Buffered output of the serializers, the counterpart of ByteSource.
+ *
+ * The serializers emit a lot of tiny fields. Collecting them in one large buffer and handing
+ * it to the stream in few big writes keeps the per field cost down to a copy. Without a
+ * stream the buffer just grows and holds the whole output.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-25
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "Core.h"
+#include "Endian.h"
+
+// Bytes collected before a sink writes them to its stream
+#define _FIN_SINK_BUFFER 256*1024
+
+namespace finapi
+{
+    class ByteSink
+    {
+    public:
+        /**
+         * @param out       Stream the output goes to, nullptr keeps all of it in memory
+         * @param capacity  Bytes collected before they are written to the stream
+         */
+        ByteSink(std::ostream* out = nullptr, c_uint capacity = _FIN_SINK_BUFFER);
+        ~ByteSink();
+
+        ByteSink(const ByteSink&) = delete;
+        ByteSink& operator=(const ByteSink&) = delete;
+
+        void write(const void* data, c_uint size)
+        {
+            if (size > buffer.size() - used) make_room(size);
+
+            std::memcpy(buffer.data() + used, data, size);
+            used += size;
+        }
+
+        /**
+         * @brief Writes a value, numbers go out little endian like the readers expect them.
+         */
+        template<typename T>
+        void write(const T& value)
+        {
+            if constexpr (std::is_arithmetic<T>::value)
+            {
+                const T stored = endian::little(value);
+                write(&stored, sizeof(T));
+            }
+            else
+                write(&value, sizeof(T));
+        }
+
+        /**
+         * @brief Hands everything collected so far to the stream.
+         */
+        void flush();
+
+        /**
+         * @brief Whether every write to the stream went through.
+         */
+        bool good() const;
+
+        /**
+         * @brief Output that hasn't been flushed, all of it for a sink without a stream.
+         */
+        const char* data() const
+            { return buffer.data(); }
+
+        unsigned int size() const
+            { return used; }
+
+        /**
+         * @brief Drops the buffered output, keeping the memory for the next use.
+         */
+        void clear()
+            { used = 0; }
+
+    private:
+        void make_room(c_uint size);
+
+        std::ostream*     out;
+        std::vector<char> buffer;
+        unsigned int      used;
+    };
+}
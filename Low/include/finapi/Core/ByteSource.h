@@ -0,0 +1,114 @@
+/**
+ * @file ByteSource.h
+ *
+ * @brief Cursor over a contiguous block of bytes, the common input of the deserializers.
+ *
+ * Anything that can present its contents as one block of memory (a downloaded file, a
+ * memory mapped file, a decompressed block) hands the deserializers a ByteSource rather
+ * than needing its own instantiation of every deserialize template.
+ *
+ * Reads never go past the end of the block. One that would is cut off, the missing bytes
+ * read as zero and the source is marked truncated, so a deserializer can check a whole
+ * record with fits() once and report a short file through truncated afterwards.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-18
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "Core.h"
+#include "Endian.h"
+
+namespace finapi
+{
+    struct ByteSource
+    {
+        const char*  data;
+        unsigned int size;
+        unsigned int position;
+
+        // Set once a read or skip ran into the end of the block
+        bool         truncated;
+
+        ByteSource(const char* data = nullptr, c_uint size = 0) :
+            data(data), size(size), position(0), truncated(false)
+        {   }
+
+        /**
+         * @brief Whether the next bytes are all there, marking the source truncated if not.
+         */
+        bool fits(c_uint count)
+        {
+            if (count <= size - position) return true;
+
+            truncated = true;
+            return false;
+        }
+
+        /**
+         * @brief Copies the next bytes out and moves past them.
+         */
+        void read(void* dest, c_uint count)
+        {
+            if (fits(count))
+            {
+                std::memcpy(dest, data + position, count);
+                position += count;
+                return;
+            }
+
+            const unsigned int have = remaining();
+            std::memcpy(dest, data + position, have);
+            std::memset((char*)dest + have, 0, count - have);
+            position = size;
+        }
+
+        /**
+         * @brief Points at the next bytes in place and moves past them.
+         *
+         * @return const char* Start of the bytes, nullptr if the block ends before them
+         */
+        const char* read_span(c_uint count)
+        {
+            if (!fits(count)) { position = size; return nullptr; }
+
+            const char* r = data + position;
+            position += count;
+            return r;
+        }
+
+        /**
+         * @brief Reads an array of little endian numbers with a single bounds check.
+         *
+         * @return bool Whether all of them were there, missing ones read as zero
+         */
+        template<typename T>
+        bool read_array(T* dest, c_uint count)
+        {
+            const bool whole = (count * sizeof(T) <= remaining());
+            read(dest, count * sizeof(T));
+            endian::little(dest, count);
+            return whole;
+        }
+
+        /**
+         * @brief Moves past bytes without reading them.
+         */
+        void skip(c_uint count)
+            { position = (fits(count) ? position + count : size); }
+
+        const char* current() const
+            { return data + position; }
+
+        unsigned int remaining() const
+            { return size - position; }
+
+        explicit operator bool() const
+            { return data != nullptr; }
+    };
+}
@@ -0,0 +1,95 @@
+/**
+ * @file Compress.h
+ *
+ * @brief Small LZ-style block codec for chunk transfers and cached files.
+ *
+ * DataTag files are repetitive text, so even a simple byte oriented LZ77 pass without
+ * entropy coding shrinks them several fold while decoding at memory speed. Every block
+ * stands on its own, so chunks can still be fetched and decoded in any order.
+ *
+ * A block is a header followed by its payload:
+ *
+ *      [u32 size][u32 raw][size bytes]
+ *
+ * The header is stored little endian like every other number, on disk and on the wire.
+ * When size equals raw the payload is stored as is, otherwise it holds sequences of a
+ * token byte (literal count in the high nibble, match length - 4 in the low one, 15 meaning
+ * more length bytes follow), the literals, and a little endian u16 match offset. The last
+ * sequence only holds literals.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-23
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "Core.h"
+#include "Endian.h"
+
+// Largest block, header included, the payload of a given raw size can take up
+#define _FIN_BLOCK_BOUND(raw) ((raw) + 8)
+
+namespace finapi
+{
+namespace compress
+{
+    /**
+     * @brief Header of a block in host byte order, see load_header() for reading a stored one.
+     */
+    struct block_header
+    {
+        unsigned int size;
+        unsigned int raw;
+    };
+
+    /**
+     * @brief Reads a stored block header, the source may be unaligned.
+     */
+    inline block_header load_header(const void* source)
+    {
+        const char* at = (const char*)source;
+        return { endian::load<unsigned int>(at), endian::load<unsigned int>(at + sizeof(unsigned int)) };
+    }
+
+    /**
+     * @brief Compresses bytes into a payload.
+     *
+     * @param src           Bytes to compress
+     * @param size          Amount of bytes
+     * @param dest          Where the payload is written
+     * @param capacity      Room at the destination
+     * @return unsigned int Length of the payload, zero if it wouldn't fit
+     */
+    unsigned int encode(const char* src, c_uint size, char* dest, c_uint capacity);
+
+    /**
+     * @brief Decompresses a payload.
+     *
+     * @param src       Payload to decompress
+     * @param size      Length of the payload
+     * @param dest      Where the bytes are written
+     * @param raw       Amount of bytes the payload has to decode to
+     * @return bool     Whether the payload was well formed and decoded to exactly raw bytes
+     */
+    bool decode(const char* src, c_uint size, char* dest, c_uint raw);
+
+    /**
+     * @brief Writes a whole block, storing the bytes as they are if they don't compress.
+     *
+     * @param src           Bytes to compress
+     * @param raw           Amount of bytes
+     * @param dest          Where the block is written, must hold _FIN_BLOCK_BOUND(raw) bytes
+     * @return unsigned int Length of the block, header included
+     */
+    unsigned int write_block(const char* src, c_uint raw, char* dest);
+
+    /**
+     * @brief Unpacks the payload of a block whose header has been read already.
+     */
+    bool read_block(const block_header& header, const char* payload, char* dest);
+}
+}
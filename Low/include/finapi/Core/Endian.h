@@ -0,0 +1,122 @@
+/**
+ * @file Endian.h
+ *
+ * @brief Conversion between the byte order of the files and the one of the host.
+ *
+ * Every number in the files is stored little endian. On little endian hosts all of this
+ * compiles down to plain copies, on big endian ones the values are swapped as they are
+ * loaded or stored. The array forms swap in a tight loop the compiler can vectorize.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-27
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "Core.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#   define _FIN_BIG_ENDIAN
+#endif
+
+// MSVC has the byte swaps of GCC and Clang under its own names
+#ifdef _MSC_VER
+#   define _FIN_BSWAP16(x) _byteswap_ushort(x)
+#   define _FIN_BSWAP32(x) _byteswap_ulong(x)
+#   define _FIN_BSWAP64(x) _byteswap_uint64(x)
+#else
+#   define _FIN_BSWAP16(x) __builtin_bswap16(x)
+#   define _FIN_BSWAP32(x) __builtin_bswap32(x)
+#   define _FIN_BSWAP64(x) __builtin_bswap64(x)
+#endif
+
+namespace finapi
+{
+namespace endian
+{
+    /**
+     * @brief Reverses the bytes of a 2, 4 or 8 byte value.
+     */
+    template<typename T>
+    inline T swap(T value)
+    {
+        static_assert(sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8, "only 2, 4 and 8 byte values can be swapped");
+
+        if constexpr (sizeof(T) == 2)
+        {
+            uint16_t bits;
+            std::memcpy(&bits, &value, sizeof(T));
+            bits = _FIN_BSWAP16(bits);
+            std::memcpy(&value, &bits, sizeof(T));
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(T));
+            bits = _FIN_BSWAP32(bits);
+            std::memcpy(&value, &bits, sizeof(T));
+        }
+        else
+        {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(T));
+            bits = _FIN_BSWAP64(bits);
+            std::memcpy(&value, &bits, sizeof(T));
+        }
+
+        return value;
+    }
+
+    /**
+     * @brief Converts a value between host and file byte order, both ways.
+     */
+    template<typename T>
+    inline T little(T value)
+    {
+#ifdef _FIN_BIG_ENDIAN
+        if constexpr (sizeof(T) > 1) return swap(value);
+#endif
+        return value;
+    }
+
+    /**
+     * @brief Converts an array between host and file byte order in place.
+     */
+    template<typename T>
+    inline void little(T* values, c_uint count)
+    {
+#ifdef _FIN_BIG_ENDIAN
+        if constexpr (sizeof(T) > 1)
+            for (unsigned int i = 0; i < count; i++)
+                values[i] = swap(values[i]);
+#else
+        (void)values; (void)count;
+#endif
+    }
+
+    /**
+     * @brief Loads a value stored in file byte order, the source may be unaligned.
+     */
+    template<typename T>
+    inline T load(const void* source)
+    {
+        T r;
+        std::memcpy(&r, source, sizeof(T));
+        return little(r);
+    }
+
+    /**
+     * @brief Loads an array of values stored in file byte order.
+     */
+    template<typename T>
+    inline void load(T* dest, const void* source, c_uint count)
+    {
+        std::memcpy(dest, source, count * sizeof(T));
+        little(dest, count);
+    }
+}
+}
@@ -0,0 +1,94 @@
+/**
+ * @file Intern.h
+ *
+ * @brief Process-wide table of immutable, shared strings.
+ *
+ * Most DataTag fields hold one of a few values ("debit", "credit", "USD", ...) that would
+ * otherwise be allocated again for every tag of every statement. Interning hands out a
+ * single copy of each distinct string, so identical strings share memory and can be
+ * compared by pointer. Interned strings live until the program exits and must never be
+ * freed.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-16
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "Arena.h"
+
+// Amount of independently locked shards in the table
+#define _FIN_INTERN_SHARDS 16
+
+namespace finapi
+{
+    class InternTable
+    {
+    public:
+        struct stats
+        {
+            unsigned long lookups;
+            unsigned long hits;
+            unsigned long strings;
+            unsigned long bytes_stored;
+            unsigned long bytes_saved;
+
+            double hit_rate() const
+                { return (lookups ? (double)hits / lookups : 0.0); }
+        };
+
+        InternTable();
+
+        /**
+         * @brief Returns the shared copy of a string, adding it to the table if it's new.
+         *
+         * @param str           Characters of the string, need not be terminated
+         * @param length        Length of the string
+         * @return const char*  Terminated string owned by the table
+         */
+        const char* intern(const char* str, c_uint length);
+
+        const char* intern(std::string_view str)
+            { return intern(str.data(), str.size()); }
+
+        /**
+         * @brief Whether the deserializers intern the repetitive fields, on by default.
+         */
+        bool enabled() const
+            { return on.load(std::memory_order_relaxed); }
+
+        void set_enabled(const bool enabled)
+            { on.store(enabled, std::memory_order_relaxed); }
+
+        /**
+         * @brief Snapshot of the hit rate and memory saved so far.
+         */
+        stats statistics() const;
+
+    private:
+        struct shard
+        {
+            std::mutex                                        mutex;
+            std::unordered_map<std::string_view, const char*> strings;
+            Arena                                             storage;
+        };
+
+        shard shards[_FIN_INTERN_SHARDS];
+
+        std::atomic<bool>          on;
+        std::atomic<unsigned long> lookups;
+        std::atomic<unsigned long> hits;
+        std::atomic<unsigned long> strings;
+        std::atomic<unsigned long> bytes_stored;
+        std::atomic<unsigned long> bytes_saved;
+    };
+
+    /**
+     * @brief Table shared by every deserializer in the process.
+     */
+    InternTable& interned();
+}
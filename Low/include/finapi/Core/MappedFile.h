@@ -0,0 +1,60 @@
+/**
+ * @file MappedFile.h
+ *
+ * @brief Read-only memory mapping of a local file.
+ *
+ * Parsing a local cache file through std::ifstream costs a stream call for every field.
+ * Mapping the file instead lets the deserializers read it straight out of the page cache
+ * through a ByteSource.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-18
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "ByteSource.h"
+
+namespace finapi
+{
+    class MappedFile
+    {
+    public:
+        /**
+         * Files of 4 GiB or more are not mapped, their size doesn't fit the unsigned int sizes.
+         *
+         * @param path Path of the file to map, check valid() afterwards
+         */
+        MappedFile(const char* path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool valid() const
+            { return ptr != nullptr; }
+
+        const char* data() const
+            { return ptr; }
+
+        unsigned int size() const
+            { return length; }
+
+        /**
+         * @brief Cursor over the whole file, valid as long as the mapping is.
+         */
+        ByteSource source() const
+            { return ByteSource(ptr, length); }
+
+    private:
+        const char*  ptr;
+        unsigned int length;
+
+        // Whether ptr is a mapping, or a heap copy on platforms without mmap
+        bool         mapped;
+    };
+}
@@ -0,0 +1,241 @@
+/**
+ * @file Metrics.h
+ *
+ * @brief Always-on counters and latency histograms of the client.
+ *
+ * Every event is a single relaxed atomic add into the shard of the thread that records it,
+ * so recording costs a few nanoseconds and never takes a lock. Threads are dealt out over
+ * _FIN_METRIC_SHARDS shards round robin, so with more threads than that some share a shard
+ * and contend on its cache lines, which slows them down but never loses an event. The
+ * shards are only summed up when a snapshot is taken.
+ *
+ * Latencies go into log-linear histograms in the manner of HdrHistogram: every power of two
+ * of nanoseconds is split into 2^_FIN_METRIC_PRECISION buckets, which keeps the error of a
+ * percentile within 1 / 2^_FIN_METRIC_PRECISION from a nanosecond up to about a minute.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-29
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "Core.h"
+
+// Amount of shards the threads are spread over
+#define _FIN_METRIC_SHARDS 8
+
+// Bits of every power of two kept by the histograms, 4 is within 6.25%
+#define _FIN_METRIC_PRECISION 4
+
+// Largest power of two of nanoseconds told apart, longer events go into the last bucket
+#define _FIN_METRIC_RANGE 36
+
+namespace finapi
+{
+namespace metrics
+{
+    enum counter
+    {
+        CONNECTS,           // Sockets connected to a server
+        CONNECT_FAILURES,   // Connections that couldn't be made
+        LOGIN_FAILURES,     // Sessions the server turned down
+        COMMANDS,           // Commands sent, chunk requests included
+        CHUNKS,             // Chunks received in full
+        CHUNK_FAILURES,     // Chunk requests that came back broken
+        CHUNK_RETRIES,      // Chunk requests sent again after a failure
+        BYTES_SENT,
+        BYTES_RECEIVED,
+        COUNTERS
+    };
+
+    enum histogram
+    {
+        CONNECT_TIME,       // Connecting a socket
+        LOGIN_TIME,         // LOGIN round trip
+        EXISTS_TIME,        // exists round trip
+        SIZE_TIME,          // SZE round trip
+        CHUNK_COUNT_TIME,   // CHK round trip
+        COMMAND_TIME,       // Round trip of any other command
+        CHUNK_TIME,         // Request and receipt of a chunk, or of a whole range
+        FILE_TIME,          // get_file and get_files from start to end
+        DESERIALIZE_TIME,   // A deserialize call
+        HISTOGRAMS
+    };
+
+    typedef std::chrono::steady_clock clock;
+
+    static constexpr unsigned int SUB_BUCKETS = 1u << _FIN_METRIC_PRECISION;
+    static constexpr unsigned int BUCKETS     = (_FIN_METRIC_RANGE - _FIN_METRIC_PRECISION + 1) * SUB_BUCKETS;
+
+    /**
+     * @brief Position of the highest bit set, the value must not be zero.
+     */
+    inline unsigned int highest_bit(const unsigned long long value)
+    {
+    #ifdef _MSC_VER
+        unsigned long r;
+        _BitScanReverse64(&r, value);
+        return r;
+    #else
+        return 63 - __builtin_clzll(value);
+    #endif
+    }
+
+    /**
+     * @brief Bucket holding a value, values under SUB_BUCKETS are kept exactly.
+     */
+    inline unsigned int bucket(const unsigned long long value)
+    {
+        if (value < SUB_BUCKETS) return value;
+
+        const unsigned int exponent = highest_bit(value);
+        const unsigned int index    = (exponent - _FIN_METRIC_PRECISION + 1) * SUB_BUCKETS +
+                                      ((value >> (exponent - _FIN_METRIC_PRECISION)) & (SUB_BUCKETS - 1));
+
+        return (index < BUCKETS ? index : BUCKETS - 1);
+    }
+
+    /**
+     * @brief Smallest value that lands in a bucket.
+     */
+    inline unsigned long long bucket_floor(const unsigned int index)
+    {
+        if (index < SUB_BUCKETS) return index;
+
+        const unsigned int exponent = index / SUB_BUCKETS + _FIN_METRIC_PRECISION - 1;
+        return (unsigned long long)(SUB_BUCKETS + index % SUB_BUCKETS) << (exponent - _FIN_METRIC_PRECISION);
+    }
+
+    struct alignas(64) shard
+    {
+        std::atomic<unsigned long long> counters[COUNTERS];
+
+        struct
+        {
+            std::atomic<unsigned long long> sum;
+            std::atomic<unsigned long long> buckets[BUCKETS];
+        } histograms[HISTOGRAMS];
+    };
+
+    /**
+     * @brief Shard of the calling thread, handed out round robin on first use.
+     */
+    shard& assign_shard();
+
+    inline shard& local()
+    {
+        static thread_local shard& r = assign_shard();
+        return r;
+    }
+
+    inline void add(const counter c, const unsigned long long amount = 1)
+    {
+        local().counters[c].fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    inline void record(const histogram h, const unsigned long long nanoseconds)
+    {
+        auto& dist = local().histograms[h];
+        dist.buckets[bucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        dist.sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    inline void record(const histogram h, const clock::time_point start)
+    {
+        record(h, std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+    }
+
+    /**
+     * @brief Records the time from its construction to the end of its scope.
+     */
+    class scope
+    {
+    public:
+        explicit scope(const histogram h) :
+            h(h), start(clock::now())
+        {   }
+
+        ~scope()
+            { record(h, start); }
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+    private:
+        const histogram         h;
+        const clock::time_point start;
+    };
+
+    /**
+     * @brief Histogram of a command sent by make_request() or request_frame(), by its verb.
+     */
+    inline histogram command_histogram(const char* command)
+    {
+        switch (command[0])
+        {
+            case 'e': return EXISTS_TIME;
+            case 'L': return LOGIN_TIME;
+            case 'S': return SIZE_TIME;
+            case 'C': return (command[1] == 'H' ? CHUNK_COUNT_TIME : COMMAND_TIME);
+            default:  return COMMAND_TIME;
+        }
+    }
+
+    struct distribution
+    {
+        unsigned long long              count;
+        unsigned long long              sum;
+        std::vector<unsigned long long> buckets;
+
+        double mean() const
+            { return (count ? (double)sum / count : 0.0); }
+
+        /**
+         * @brief Nanoseconds below which a share p of the events fall, midpoint of its bucket.
+         */
+        double percentile(const double p) const;
+    };
+
+    struct snapshot
+    {
+        unsigned long long counters[COUNTERS];
+        distribution       histograms[HISTOGRAMS];
+
+        unsigned long long operator[](const counter c) const
+            { return counters[c]; }
+
+        const distribution& operator[](const histogram h) const
+            { return histograms[h]; }
+    };
+
+    /**
+     * @brief Sums every shard up.
+     *
+     * Events recorded while it runs may or may not be part of it, but nothing is counted twice.
+     */
+    snapshot collect();
+
+    /**
+     * @brief Zeroes every counter and histogram.
+     */
+    void reset();
+
+    const char* name(const counter c);
+    const char* name(const histogram h);
+
+    /**
+     * @brief Text exposition of a snapshot, one "name value" line per sample.
+     *
+     * Counters end in _total, histograms are written as summaries in seconds with the
+     * 0.5, 0.9, 0.99 and 0.999 quantiles, their _sum and their _count.
+     */
+    std::string expose(const snapshot& s);
+
+    inline std::string expose()
+        { return expose(collect()); }
+}
+}
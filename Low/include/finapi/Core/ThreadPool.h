@@ -0,0 +1,127 @@
+/**
+ * @file ThreadPool.h
+ *
+ * @brief Fixed-size pool of reusable worker threads.
+ *
+ * Each worker owns a queue of tasks. Tasks submitted from outside the pool are dealt out
+ * round robin, tasks submitted from inside a worker land on that worker's own queue, and
+ * a worker that runs out of work steals from the back of the other queues.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-05
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "Core.h"
+
+namespace finapi
+{
+    /**
+     * @brief Counter used to wait on a batch of tasks submitted to a ThreadPool.
+     */
+    class TaskGroup
+    {
+    public:
+        TaskGroup();
+
+        /**
+         * @brief Registers more tasks with the group.
+         */
+        void add(c_uint count = 1);
+
+        /**
+         * @brief Marks a single task as finished.
+         */
+        void done();
+
+        /**
+         * @brief Blocks until every registered task has finished.
+         */
+        void wait();
+
+    private:
+        std::mutex              mutex;
+        std::condition_variable finished;
+        unsigned int            remaining;
+    };
+
+    class ThreadPool
+    {
+    public:
+        typedef std::function<void()> task;
+
+        /**
+         * @param workers Amount of threads, zero picks the hardware concurrency
+         */
+        ThreadPool(c_uint workers = 0);
+
+        /**
+         * @brief Lets the running tasks finish and runs the queued ones, none is dropped.
+         */
+        ~ThreadPool();
+
+        /**
+         * @brief Queues a task to be run by one of the workers.
+         *
+         * A task submitting from a worker while the pool is being stopped is run right
+         * away by that worker instead, its queue may not be picked up again.
+         *
+         * @param t     Task to run
+         * @param group Optional group notified once the task has run
+         */
+        void submit(task t, TaskGroup* group = nullptr);
+
+        /**
+         * @brief Changes the amount of worker threads.
+         *
+         * Running tasks are finished first, tasks still waiting in the queues are kept and
+         * picked up by the new workers. Must not be called from a task of the pool.
+         *
+         * @param workers Amount of threads, zero picks the hardware concurrency
+         */
+        void resize(c_uint workers);
+
+        unsigned int size();
+
+    private:
+        struct queue
+        {
+            std::mutex       mutex;
+            std::deque<task> tasks;
+        };
+
+        void start(c_uint workers);
+
+        /**
+         * @brief Joins every worker, control must not be held since running tasks may submit.
+         */
+        void stop();
+
+        void work(c_uint index);
+
+        /**
+         * @brief Takes a task off the worker's own queue, or steals one from another worker.
+         */
+        bool pop(c_uint index, task& t);
+
+        // Held for a whole resize or destruction, so workers are only ever joined by one caller
+        std::mutex              resizing;
+
+        std::mutex              control;
+        std::vector<std::thread> workers;
+        std::vector<queue*>      queues;
+
+        std::mutex              sleep;
+        std::condition_variable wake;
+        std::atomic<unsigned>   pending;
+        std::atomic<unsigned>   next;
+
+        // Written with both control and sleep held
+        bool                    stopping;
+    };
+}
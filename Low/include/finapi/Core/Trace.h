@@ -0,0 +1,138 @@
+/**
+ * @file Trace.h
+ *
+ * @brief Opt-in timeline of what a download spent its time on, viewable in chrome://tracing.
+ *
+ * Spans are kept in a ring buffer that threads claim slots of with a single atomic add, so
+ * tracing never takes a lock. Once the ring is full the oldest spans are overwritten. A span
+ * still being written when the ring laps it is skipped by the export.
+ *
+ * Spans carry the name of the file and the index of the chunk they belong to. A scope opened
+ * with those tags hands them on to every span opened inside it on the same thread, which is
+ * how connecting and logging in, done deep inside the pool, end up on the chunk they were
+ * done for.
+ *
+ * Off by default, a scope then costs a relaxed load and a branch.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-30
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "Core.h"
+
+// Spans kept in the ring buffer
+#define _FIN_TRACE_CAPACITY (1 << 16)
+
+// Characters of a filename kept with a span
+#define _FIN_TRACE_FILENAME 48
+
+namespace finapi
+{
+namespace trace
+{
+    typedef std::chrono::steady_clock clock;
+
+    struct span
+    {
+        const char*  name;
+        char         file[_FIN_TRACE_FILENAME];
+        int          chunk;
+        unsigned int thread;
+
+        // Nanoseconds since tracing was first started
+        long long    start;
+        long long    duration;
+    };
+
+    extern std::atomic<bool> active;
+
+    inline bool enabled()
+        { return active.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Starts recording, the ring buffer is allocated the first time.
+     */
+    void start();
+
+    /**
+     * @brief Stops recording, the spans already recorded are kept.
+     */
+    void stop();
+
+    /**
+     * @brief Drops every recorded span.
+     */
+    void clear();
+
+    /**
+     * @brief Records a span that has already ended.
+     *
+     * @param name  Static string naming the phase
+     * @param file  Filename the span belongs to, nullptr for the one of the enclosing scope
+     * @param chunk Chunk the span belongs to, -1 for the one of the enclosing scope
+     * @param begin When the span started
+     */
+    void record(const char* name, const char* file, const int chunk, const clock::time_point begin);
+
+    /**
+     * @brief Times its own lifetime as a span, if tracing is on when it is opened.
+     */
+    class scope
+    {
+    public:
+        explicit scope(const char* name) :
+            scope(name, nullptr, -1)
+        {   }
+
+        /**
+         * @brief Opens a span that also tags every span opened inside it on this thread.
+         */
+        scope(const char* name, const char* file, const int chunk = -1);
+
+        ~scope()
+            { if (on) close(); }
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+    private:
+        void open(const char* file, const int chunk);
+        void close();
+
+        const char*       name;
+        bool              on;
+        const char*       outer_file;
+        int               outer_chunk;
+        clock::time_point begin;
+    };
+
+    inline scope::scope(const char* name, const char* file, const int chunk) :
+        name(name), on(enabled())
+    {
+        if (on) open(file, chunk);
+    }
+
+    /**
+     * @brief Spans still in the ring, oldest first.
+     */
+    std::vector<span> spans();
+
+    /**
+     * @brief The recorded spans as Chrome trace_event JSON, complete ("X") events in microseconds.
+     */
+    std::string chrome_json();
+
+    /**
+     * @brief Writes chrome_json() to a file.
+     *
+     * @return bool Whether the file could be written
+     */
+    bool write_chrome(const char* path);
+}
+}
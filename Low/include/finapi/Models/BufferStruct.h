@@ -5,8 +5,10 @@
  * 
  * This problem could easily be solved using inheritance and a destructor, but doing 
  * this messes with the memory layout and thus defeats the purpose of the deserializers.
- * Now, instead of inheritance, one can just add these macros to the bottom of a list of
- * fields and pass the amount of string fields so they'll get freed up on destruction.
+ * Now, instead of inheritance, one can just add MODEL_BUFF to the bottom of a list of
+ * fields and MODEL_DEST below the model's schema (see Schema.h), and the string fields
+ * get freed up on destruction. String fields whose bit is set in the interned mask belong
+ * to the intern table and are left alone.
  * 
  * This is also where we can store our magic numbers individually.
  * 
@@ -22,20 +24,21 @@
 #pragma once
 
 #include "../Core/Core.h"
+#include "../Core/Arena.h"
+#include "../Core/Intern.h"
+#include "../Core/ByteSource.h"
+#include "../Core/ByteSink.h"
 #include "../Network/CClient.h"
+#include "Schema.h"
 
-#define CONSTRUCT_BUFF(class_name, f)\
-    class_name() : fields(f) {    }\
-    private:\
-    const unsigned int fields;\
-    public:
-
-#define CONSTRUCT_DEST(class_name)\
-    ~class_name() {\
-        char** scalar_this = (char**)this;\
-        for (unsigned int i = 0; i < fields; i++)\
-            std::free(*(scalar_this + i));\
-    }
+#define MODEL_BUFF(class_name)\
+    class_name() : interned(0) {    }\
+    ~class_name();\
+    unsigned int interned;
+
+// Goes below the schema of the model, which tells the destructor the string fields to free
+#define MODEL_DEST(class_name)\
+    inline class_name::~class_name() { schema::release(*this); }
 
 /* ---------- MAGIC NUMBER DEFINITIONS --------- */
 #define DATA_TAG_MN  0
@@ -43,12 +46,18 @@
 #define COMPANY_MN   2
 /* --------------------------------------------- */
 
+/* ------------- FORMAT VERSIONS --------------- */
+// The layout version sits in the high half of the magic number, files from before
+// versioning have none there and read as version 1. See Format.h for the v2 layout.
+#define MAGIC_NUMBER(mn)          ((mn) & 0xFFFF)
+#define MAGIC_VERSION(mn)         ((mn) >> 16 ? (mn) >> 16 : 1)
+#define VERSIONED_MN(mn, version) ((mn) | ((version) << 16))
+/* --------------------------------------------- */
+
 /* ------------ STRING DEFINITIONS ------------ */
 #define STRING_FIELD char*
-#define STRING_LIST  char**
-#define GET_STRING(var, index) *(var + index)
-#define GET_CHAR(var, index)   GET_STRING(var, index)
-#define STRING_ALLOC(length) (char*)std::malloc(length + 1)
+#define GET_CHAR(var, index) *(var + index)
+#define STRING_ALLOC(length) (char*)std::malloc((std::size_t)(length) + 1)
 /* --------------------------------------------- */
 
 namespace finapi
@@ -62,6 +71,8 @@ namespace finapi
     
 /**
  * @brief Common utility methods for extracting binary data from a given file stream.
+ * 
+ * Numbers are stored little endian and come out in host byte order.
  */
 namespace filemethods
 {
@@ -77,7 +88,7 @@ namespace filemethods
     {
         T r;
         file.read((char*)&r, sizeof(T));
-        return r;
+        return endian::little(r);
     }
 
     /**
@@ -92,7 +103,22 @@ namespace filemethods
     {
         T r;
         file->read(&r, sizeof(T));
-        return r;
+        return endian::little(r);
+    }
+
+    /**
+     * @brief Reads and returns a given type from a byte source.
+     * 
+     * @tparam T    Type to read from the source
+     * @param file  Cursor over the binary data
+     * @return T    Value from the source
+     */
+    template<typename T>
+    static T read(ByteSource& file)
+    {
+        T r;
+        file.read(&r, sizeof(T));
+        return endian::little(r);
     }
 
     /**
@@ -106,6 +132,7 @@ namespace filemethods
     static void read(std::ifstream& file, T* dest)
     {
         file.read((char*)dest, sizeof(T));
+        *dest = endian::little(*dest);
     }
 
     /**
@@ -119,6 +146,21 @@ namespace filemethods
     static void read(Cloud::File* file, T* dest)
     {
         file->read(dest, sizeof(T));
+        *dest = endian::little(*dest);
+    }
+
+    /**
+     * @brief Reads a value from a given byte source and populates the data pointer.
+     * 
+     * @tparam T    Type to pull from the source
+     * @param file  Cursor over the binary data
+     * @param dest  Destination of the data point
+     */
+    template<typename T>
+    static void read(ByteSource& file, T* dest)
+    {
+        file.read(dest, sizeof(T));
+        *dest = endian::little(*dest);
     }
 
     /**
@@ -142,6 +184,16 @@ namespace filemethods
      */
     void read(Cloud::File* file, STRING_FIELD& string);
 
+    /**
+     * @brief Reads in a string from a given byte source.
+     * 
+     * As with the other functions, the string must be an unallocated pointer.
+     * 
+     * @param file      Cursor over the binary data
+     * @param string    Pointer to an unallocated string
+     */
+    void read(ByteSource& file, STRING_FIELD& string);
+
     /**
      * @brief Simple function that reads in the magic number.
      * 
@@ -26,10 +26,28 @@ namespace finapi
         STRING_FIELD name;
         STRING_FIELD ticker;
 
-        CONSTRUCT_BUFF(Company, 5);
-        CONSTRUCT_DEST(Company);
+        MODEL_BUFF(Company);
     };
 
+    /**
+     * @brief Layout of a Company file.
+     */
+    template<>
+    struct schema::model<Company>
+    {
+        static constexpr unsigned int magic = COMPANY_MN;
+
+        typedef fields<
+            field<&Company::cik,    STRING>,
+            field<&Company::id,     STRING>,
+            field<&Company::lei,    STRING>,
+            field<&Company::name,   STRING>,
+            field<&Company::ticker, STRING>
+        > layout;
+    };
+
+    MODEL_DEST(Company);
+
     /**
      * @brief Deserializes a Company object from a given binary file stream.
      * 
@@ -38,4 +56,22 @@ namespace finapi
      */
     template<typename T>
     void deserialize(Company** data, T& file);
+
+    /**
+     * @brief Deserializes a Company object that lives in an arena and must not be deleted.
+     * 
+     * @param data  Pointer to an unallocated Company pointer.
+     * @param file  Binary file stream.
+     * @param arena Arena owning the object and its strings.
+     */
+    template<typename T>
+    void deserialize(Company** data, T& file, Arena& arena);
+
+    /**
+     * @brief Serializes a Company object in the layout deserialize() reads.
+     * 
+     * @param data Company to write.
+     * @param out  Sink to write to.
+     */
+    void serialize(const Company* data, ByteSink& out);
 }
\ No newline at end of file
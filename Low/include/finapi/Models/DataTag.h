@@ -16,6 +16,9 @@
 
 #include "BufferStruct.h"
 
+// Fewest records in a range of the parallel deserializer
+#define _FIN_PARALLEL_MIN_RANGE 256
+
 namespace finapi
 {
     struct DataTag
@@ -31,19 +34,104 @@ namespace finapi
         int   sequence;
         float value;
 
-        CONSTRUCT_BUFF(DataTag, 7);
-        CONSTRUCT_DEST(DataTag);
+        MODEL_BUFF(DataTag);
+    };
+
+    /**
+     * @brief Record layout of a DataTag file.
+     * 
+     * balance, factor, parent, tag and unit repeat across every statement, so they can
+     * share interned copies.
+     */
+    template<>
+    struct schema::model<DataTag>
+    {
+        static constexpr unsigned int magic = DATA_TAG_MN;
+
+        typedef fields<
+            field<&DataTag::balance,  TAGGED_STRING, true>,
+            field<&DataTag::factor,   TAGGED_STRING, true>,
+            field<&DataTag::id,       TAGGED_STRING>,
+            field<&DataTag::name,     TAGGED_STRING>,
+            field<&DataTag::parent,   TAGGED_STRING, true>,
+            field<&DataTag::sequence, INT>,
+            field<&DataTag::tag,      TAGGED_STRING, true>,
+            field<&DataTag::unit,     TAGGED_STRING, true>,
+            field<&DataTag::value,    FLOAT>
+        > layout;
     };
 
+    MODEL_DEST(DataTag);
+
     /**
      * @brief Deserializes a collection of DataTag objects from a given file stream.
      * 
      * The DataTag objects are built in this method, so before program termination, clean_list() must
      * be called.
      * 
+     * A file that is cut off ends the list at its last whole record. The file reports it: a
+     * ByteSource is marked truncated, a Cloud::File gets the PARTIAL status and a stream fails.
+     * 
      * @param data 
      * @param file 
      */
     template<typename T>
     void deserialize(std::vector<DataTag*>& data, T& file);
+
+    /**
+     * @brief Deserializes a collection of DataTag objects whose objects and strings live in an arena.
+     * 
+     * Nothing in the list is freed individually: clean_list() must NOT be called on it, the whole
+     * document goes away with Arena::release(). Entries already in the list are dropped without
+     * being freed, so it should be empty or owned by an arena as well.
+     * 
+     * @param data  List to populate
+     * @param file  Binary file to read from
+     * @param arena Arena owning everything that is read
+     */
+    template<typename T>
+    void deserialize(std::vector<DataTag*>& data, T& file, Arena& arena);
+
+    /**
+     * @brief Deserializes a range of records without parsing the ones in front of it.
+     * 
+     * v2 files jump straight to the first record through their offset table, v1 files still
+     * have to skip over everything before it. The records are appended to the list, so
+     * clean_list() must be called on it as with the other overload.
+     * 
+     * @param data  List to append to
+     * @param file  Whole DataTag file, of any version
+     * @param first Number of the first record to read
+     * @param count Amount of records to read, clipped to the end of the file
+     * @return bool  False if the file is cut off before the last record asked for, the
+     *               records in front of the cut are still appended
+     */
+    bool deserialize(std::vector<DataTag*>& data, ByteSource file, c_uint first, c_uint count);
+
+    /**
+     * @brief Deserializes a fully buffered DataTag file on several threads.
+     * 
+     * The records are split into ranges, found through the offset table of v2 files or a
+     * quick pass over the length prefixes of v1 files, and decoded straight into their slots
+     * of the list, so it comes out in file order. The calling thread decodes a range as well
+     * and must not be one of the pool's workers. As with the other overloads, the list is
+     * cleaned first and clean_list() must be called on it.
+     * 
+     * @param data  List to populate
+     * @param file  Whole DataTag file, of any version
+     * @param pool  Threads to decode on
+     * @return bool False if the file is cut off, the list then ends at its last whole record
+     */
+    bool deserialize(std::vector<DataTag*>& data, const ByteSource& file, ThreadPool& pool);
+
+    /**
+     * @brief Serializes a collection of DataTag objects in the layout deserialize() reads.
+     * 
+     * Missing string fields are written as empty strings.
+     * 
+     * @param data      Tags to write
+     * @param out       Sink to write to
+     * @param version   Layout to write, 1 or 2 (offset table and tag index, see Format.h)
+     */
+    void serialize(const std::vector<DataTag*>& data, ByteSink& out, c_uint version = 1);
 }
\ No newline at end of file
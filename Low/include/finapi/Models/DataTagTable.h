@@ -0,0 +1,126 @@
+/**
+ * @file DataTagTable.h
+ *
+ * @brief Columnar layout of a DataTag file for fast aggregation.
+ *
+ * A std::vector<DataTag*> is a list of pointers to separate heap objects, so walking the
+ * values of a statement misses the cache on nearly every element. The table stores each
+ * field as its own contiguous column instead, with the string fields dictionary encoded
+ * to integer codes, so filtering on a tag and summing its values is a linear pass over
+ * two packed arrays.
+ *
+ * @author   Max Ortner
+ * @date     2020-01-14
+ * @version  0.0.1
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#pragma once
+
+#include "BufferStruct.h"
+
+namespace finapi
+{
+    /**
+     * @brief Maps every distinct string of a column to a small integer code.
+     */
+    class Dictionary
+    {
+    public:
+        static const unsigned int npos = 0xFFFFFFFF;
+
+        /**
+         * @brief Returns the code of a string, adding it to the dictionary if it's new.
+         */
+        unsigned int encode(std::string_view str);
+
+        /**
+         * @brief Returns the code of a string, or npos if it isn't in the dictionary.
+         */
+        unsigned int find(std::string_view str) const;
+
+        std::string_view decode(c_uint code) const
+            { return strings[code]; }
+
+        unsigned int size() const
+            { return strings.size(); }
+
+        void clear();
+
+    private:
+        // A deque never moves its elements, so the views used as keys stay valid
+        std::deque<std::string>                            strings;
+        std::unordered_map<std::string_view, unsigned int> codes;
+    };
+
+    struct DataTagTable
+    {
+        enum column
+        {
+            BALANCE,
+            FACTOR,
+            ID,
+            NAME,
+            PARENT,
+            TAG,
+            UNIT,
+            COLUMNS
+        };
+
+        std::vector<float>        value;
+        std::vector<int>          sequence;
+        std::vector<unsigned int> codes[COLUMNS];
+        Dictionary                dictionaries[COLUMNS];
+
+        unsigned int size() const
+            { return value.size(); }
+
+        /**
+         * @brief Decodes a string field of a row.
+         */
+        std::string_view get(const column c, c_uint row) const
+            { return dictionaries[c].decode(codes[c][row]); }
+
+        /**
+         * @brief Looks up the code of a string in a column, npos if no row holds it.
+         */
+        unsigned int code(const column c, std::string_view str) const
+            { return dictionaries[c].find(str); }
+
+        void clear();
+
+        /* ---------------- AGGREGATIONS ---------------- */
+        // Every aggregation runs over the rows whose column c holds the given code.
+
+        unsigned int count(const column c, c_uint code) const;
+        double       sum  (const column c, c_uint code) const;
+
+        /**
+         * @brief Smallest value of the selected rows, +infinity if none match.
+         */
+        float min(const column c, c_uint code) const;
+
+        /**
+         * @brief Largest value of the selected rows, -infinity if none match.
+         */
+        float max(const column c, c_uint code) const;
+
+        /**
+         * @brief Collects the indices of the selected rows.
+         */
+        void filter(const column c, c_uint code, std::vector<unsigned int>& rows) const;
+    };
+
+    /**
+     * @brief Loads a DataTag file straight into a columnar table.
+     *
+     * Reads the same binary format as deserialize(std::vector<DataTag*>&, T&), without
+     * creating any DataTag objects.
+     *
+     * @param table Table to populate, cleared first
+     * @param file  Binary file to read from
+     */
+    template<typename T>
+    void deserialize(DataTagTable& table, T& file);
+}
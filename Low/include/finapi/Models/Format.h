@@ -0,0 +1,62 @@
+/**
+ * @file Format.h
+ *
+ * @brief Indexed v2 layout of the DataTag files.
+ *
+ * A v1 file is the magic number, the record count and the records one after another, so
+ * the only way to a record is through every record before it. v2 keeps the records as
+ * they are and puts a header in front of them:
+ *
+ *      [u32 VERSIONED_MN(DATA_TAG_MN, 2)][u32 count][u32 flags][u32 index]
+ *      [u32 offset] * count        byte offset of every record from the start of the file
+ *      records                     same encoding as v1
+ *      [u32 record] * count        record numbers ordered by tag, if TAG_INDEX is set
+ *
+ * index is the byte offset of the tag index from the start of the file, zero without one.
+ * Sequential readers skip the offset table and stop after the records, so every reader
+ * accepts both versions. Statement and Company files hold a single record and have no v2
+ * body of their own, their readers only accept the versioned magic number.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-24
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "BufferStruct.h"
+
+// Newest layout the writers produce
+#define FORMAT_VERSION 2
+
+namespace finapi
+{
+namespace format
+{
+    // Flags of the v2 header
+    static const unsigned int TAG_INDEX = 1;
+
+    struct tag_header
+    {
+        unsigned int magic;
+        unsigned int count;
+        unsigned int flags;
+        unsigned int index;
+    };
+
+    /**
+     * @brief Rewrites a DataTag file in the v2 layout.
+     *
+     * @param data      DataTag file of any version
+     * @param size      Length of the file
+     * @param out       Populated with the v2 file
+     * @param tag_index Whether to add the sorted tag index
+     * @return bool     False if the data isn't a DataTag file, is cut off or has an offset
+     *                  that doesn't point at the next record
+     */
+    bool upgrade_tags(const char* data, c_uint size, std::vector<char>& out, const bool tag_index = true);
+}
+}
@@ -0,0 +1,129 @@
+/**
+ * @file ModelCache.h
+ *
+ * @brief In-memory cache of deserialized models, keyed by filename.
+ *
+ * Hot tickers are asked for over and over, and every request paid for the transfer and the
+ * deserialization again. The cache keeps the parsed models around up to a byte budget and
+ * evicts the least recently used ones. Concurrent misses for the same file share a single
+ * download and parse.
+ *
+ * Models are handed out as shared pointers to const, so an evicted model stays valid for
+ * whoever still holds it. Instantiated for Company, Statement and std::vector<DataTag*>.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-22
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "Company.h"
+#include "DataTag.h"
+#include "Statement.h"
+
+// Default amount of memory the cached models of one cache may take up, in bytes
+#define _FIN_MODEL_CACHE_BUDGET 256ull*1024*1024
+
+namespace finapi
+{
+    template<typename T>
+    class ModelCache
+    {
+    public:
+        struct stats
+        {
+            unsigned long hits;
+            unsigned long misses;
+            unsigned long coalesced;
+            unsigned long evictions;
+            unsigned long entries;
+            unsigned long long bytes;
+
+            double hit_rate() const
+                { return (hits + misses ? (double)hits / (hits + misses) : 0.0); }
+        };
+
+        /**
+         * @param budget Bytes the cached models may take up, strings and objects included
+         */
+        ModelCache(const unsigned long long budget = _FIN_MODEL_CACHE_BUDGET);
+
+        ModelCache(const ModelCache&) = delete;
+        ModelCache& operator=(const ModelCache&) = delete;
+
+        /**
+         * @brief Returns the model of a file, downloading and parsing it on a miss.
+         *
+         * While a file is being loaded, other callers asking for it wait for that load
+         * instead of starting their own. Failed loads are not cached.
+         *
+         * @param filename  Name of the file on the server
+         * @param address   IP Address of the server
+         * @param status    Populated with the status of the download if not null
+         * @return std::shared_ptr<const T> The model, null if the file could not be pulled
+         */
+        std::shared_ptr<const T> get(const char* filename, const char* address, Cloud::Status* status = nullptr);
+
+        /**
+         * @brief Drops a file so the next request pulls it again.
+         */
+        void erase(const char* filename);
+
+        void clear();
+
+        void set_budget(const unsigned long long budget);
+
+        stats statistics();
+
+        /**
+         * @brief Memory a model takes up, strings shared through the intern table aside.
+         */
+        static unsigned long long footprint(const T& model);
+
+    private:
+        struct result
+        {
+            std::shared_ptr<const T> model;
+            Cloud::Status            status;
+        };
+
+        struct entry
+        {
+            std::shared_ptr<const T>         model;
+            unsigned long long               bytes;
+            std::list<std::string>::iterator use;
+        };
+
+        /**
+         * @brief Downloads and deserializes a file.
+         */
+        static result load(const char* filename, const char* address);
+
+        /**
+         * @brief Drops the least recently used models until the budget is met, mutex must be held.
+         */
+        void evict();
+
+        std::mutex                                                    mutex;
+        unsigned long long                                            budget;
+        unsigned long long                                            bytes;
+
+        // Most recently used at the front
+        std::list<std::string>                                        order;
+        std::unordered_map<std::string, entry>                        entries;
+        std::unordered_map<std::string, std::shared_future<result>>   loading;
+
+        unsigned long hits;
+        unsigned long misses;
+        unsigned long coalesced;
+        unsigned long evictions;
+    };
+
+    template<> unsigned long long ModelCache<Company>::footprint(const Company& model);
+    template<> unsigned long long ModelCache<Statement>::footprint(const Statement& model);
+    template<> unsigned long long ModelCache<std::vector<DataTag*>>::footprint(const std::vector<DataTag*>& model);
+}
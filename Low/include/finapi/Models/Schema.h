@@ -0,0 +1,224 @@
+/**
+ * @file Schema.h
+ *
+ * @brief Compile-time description of the fields of every model.
+ *
+ * Each model lists its fields, in the order they appear in the file, as a specialization
+ * of schema::model. The readers, writers, views and the destructors walk that list through
+ * visit(), which expands into straight-line code with one call per field, so nothing
+ * depends on casting a model to char** or on hard-coded field positions anymore. The field
+ * types are checked against the members they point at when the schema is compiled.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-26
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "../Core/Core.h"
+#include "../Core/Endian.h"
+
+namespace finapi
+{
+namespace schema
+{
+    enum kind
+    {
+        STRING,         // [u32 length][bytes]
+        TAGGED_STRING,  // [u32 length][u32 length][bytes], the DataTag strings
+        INT,
+        FLOAT
+    };
+
+    template<typename C, typename M>
+    M member_type(M C::*);
+
+    /**
+     * @brief A single field of a model.
+     *
+     * @tparam Member   Pointer to the member the field is read into
+     * @tparam Type     How the field is stored in the file
+     * @tparam Intern   Whether the field repeats enough to share an interned copy
+     */
+    template<auto Member, kind Type, bool Intern = false>
+    struct field
+    {
+        typedef decltype(member_type(Member)) value_type;
+
+        static constexpr auto member = Member;
+        static constexpr kind type   = Type;
+        static constexpr bool intern = Intern;
+        static constexpr bool string = (Type == STRING || Type == TAGGED_STRING);
+
+        static_assert(string ? std::is_same<value_type, char*>::value :
+                      Type == INT ? std::is_same<value_type, int>::value : std::is_same<value_type, float>::value,
+                      "the kind of a field has to match the type of its member");
+
+        static_assert(!Intern || string, "only string fields can be interned");
+    };
+
+    /**
+     * @brief The fields of a model in file order.
+     */
+    template<typename... Fields>
+    struct fields
+    {
+        static constexpr unsigned int count   = sizeof...(Fields);
+        static constexpr unsigned int strings = (0u + ... + (Fields::string ? 1u : 0u));
+
+        static_assert(strings <= 32, "the interned mask holds one bit per string field");
+    };
+
+    /**
+     * @brief Schema of a model, specialized next to every model.
+     *
+     * A specialization provides the magic number of the model's files and its fields:
+     *
+     *      static constexpr unsigned int magic = ...;
+     *      typedef fields<...> layout;
+     */
+    template<typename T>
+    struct model;
+
+    /**
+     * @brief A field as handed to a visitor, along with its position among the string fields.
+     *
+     * The position is also the field's bit in the interned mask of the model.
+     */
+    template<typename F, unsigned int Index>
+    struct slot : F
+    {
+        static constexpr unsigned int index = Index;
+    };
+
+    template<typename... F>
+    constexpr unsigned int string_index(const std::size_t position)
+    {
+        const bool strings[] = { F::string..., false };
+
+        unsigned int r = 0;
+        for (std::size_t i = 0; i < position; i++)
+            r += strings[i];
+
+        return r;
+    }
+
+    template<typename V, typename... F, std::size_t... I>
+    constexpr void visit(V&& visitor, fields<F...>, std::index_sequence<I...>)
+    {
+        (visitor(slot<F, string_index<F...>(I)>()), ...);
+    }
+
+    /**
+     * @brief Calls the visitor with every field of a model, in file order.
+     *
+     * @param visitor Generic callable, takes a slot<> whose members describe the field
+     */
+    template<typename T, typename V>
+    constexpr void visit(V&& visitor)
+    {
+        typedef typename model<T>::layout layout;
+        visit(visitor, layout(), std::make_index_sequence<layout::count>());
+    }
+
+    template<typename... F, std::size_t... I>
+    constexpr unsigned int intern_mask(fields<F...>, std::index_sequence<I...>)
+    {
+        return (0u | ... | (F::intern ? 1u << string_index<F...>(I) : 0u));
+    }
+
+    /**
+     * @brief Bits of the string fields of a model that may be interned.
+     */
+    template<typename T>
+    constexpr unsigned int intern_mask()
+    {
+        typedef typename model<T>::layout layout;
+        return intern_mask(layout(), std::make_index_sequence<layout::count>());
+    }
+
+    /**
+     * @brief Fewest bytes a record of a model takes up, the one with every string empty.
+     */
+    template<typename T>
+    constexpr unsigned int min_size()
+    {
+        unsigned int r = 0;
+        visit<T>([&r](auto field)
+        {
+            typedef decltype(field) F;
+
+            if constexpr (F::type == TAGGED_STRING)
+                r += 2 * sizeof(unsigned int);
+            else if constexpr (F::type == STRING)
+                r += sizeof(unsigned int);
+            else
+                r += sizeof(typename F::value_type);
+        });
+
+        return r;
+    }
+
+    /**
+     * @brief Finds the end of a record without decoding it, checking it against the buffer.
+     *
+     * Only the length prefixes are looked at, so once a record fits it can be decoded
+     * without any further bounds checks.
+     *
+     * @param record        Start of the record
+     * @param end           End of the buffer the record is in
+     * @return const char*  End of the record, nullptr if it runs past the buffer
+     */
+    template<typename T>
+    inline const char* extent(const char* record, const char* end)
+    {
+        bool fits = true;
+        visit<T>([&](auto field)
+        {
+            typedef decltype(field) F;
+            if (!fits) return;
+
+            if constexpr (!F::string)
+            {
+                fits = (end - record >= (std::ptrdiff_t)sizeof(typename F::value_type));
+                if (fits) record += sizeof(typename F::value_type);
+            }
+            else
+            {
+                // Every DataTag string carries an extra length word in front of its own
+                const unsigned int prefix = (F::type == TAGGED_STRING ? 2 : 1) * sizeof(unsigned int);
+
+                fits = (end - record >= (std::ptrdiff_t)prefix);
+                if (!fits) return;
+
+                const unsigned int size = endian::load<unsigned int>(record + prefix - sizeof(unsigned int));
+                fits = (end - record - prefix >= (std::ptrdiff_t)size);
+                if (fits) record += prefix + size;
+            }
+        });
+
+        return (fits ? record : nullptr);
+    }
+
+    /**
+     * @brief Frees the string fields of a model that don't belong to the intern table.
+     */
+    template<typename T>
+    inline void release(T& object)
+    {
+        visit<T>([&object](auto field)
+        {
+            typedef decltype(field) F;
+            if constexpr (F::string)
+            {
+                if (!(object.interned & (1u << F::index)))
+                    std::free(object.*F::member);
+            }
+        });
+    }
+}
+}
@@ -35,10 +35,31 @@ namespace finapi
 
         int          fiscal_year;
 
-        CONSTRUCT_BUFF(Statement, 7);
-        CONSTRUCT_DEST(Statement);
+        MODEL_BUFF(Statement);
     };
 
+    /**
+     * @brief Layout of a Statement file, the fiscal year sits in between the strings.
+     */
+    template<>
+    struct schema::model<Statement>
+    {
+        static constexpr unsigned int magic = STATEMENT_MN;
+
+        typedef fields<
+            field<&Statement::end_date,       STRING>,
+            field<&Statement::filing_date,    STRING>,
+            field<&Statement::fiscal_period,  STRING>,
+            field<&Statement::fiscal_year,    INT>,
+            field<&Statement::id,             STRING>,
+            field<&Statement::start_date,     STRING>,
+            field<&Statement::statement_code, STRING>,
+            field<&Statement::type,           STRING>
+        > layout;
+    };
+
+    MODEL_DEST(Statement);
+
     /**
      * @brief Deserializes a Statement object from a given file stream.
      * 
@@ -46,5 +67,23 @@ namespace finapi
      * @param file Binary file stream to read from.
      */
     template<typename T>
-    static void deserialize(Statement** data, T& file);
+    void deserialize(Statement** data, T& file);
+
+    /**
+     * @brief Deserializes a Statement object that lives in an arena and must not be deleted.
+     * 
+     * @param data  Pointer to an unallocated Statement pointer.
+     * @param file  Binary file stream to read from.
+     * @param arena Arena owning the object and its strings.
+     */
+    template<typename T>
+    void deserialize(Statement** data, T& file, Arena& arena);
+
+    /**
+     * @brief Serializes a Statement object in the layout deserialize() reads.
+     * 
+     * @param data Statement to write.
+     * @param out  Sink to write to.
+     */
+    void serialize(const Statement* data, ByteSink& out);
 }
\ No newline at end of file
@@ -0,0 +1,237 @@
+/**
+ * @file View.h
+ *
+ * @brief Read-only views over the models of a downloaded file, without copying anything out.
+ *
+ * The string fields are std::string_views pointing straight into the file buffer, and a
+ * record is only decoded the first time one of its fields is accessed. The file the view
+ * was made from must outlive the view.
+ *
+ * Every view knows where its buffer ends. A record that runs past it reads as empty
+ * strings and zeros, and walking a DataTag file stops at its last whole record.
+ *
+ * @author   Max Ortner
+ * @date     2020-01-12
+ * @version  0.0.1
+ *
+ * @copyright Copyright (c) 2020
+ */
+
+#pragma once
+
+#include "DataTag.h"
+#include "Statement.h"
+#include "Company.h"
+
+namespace finapi
+{
+    /**
+     * @brief View of a single DataTag record.
+     */
+    class DataTagView
+    {
+    public:
+        /**
+         * @param record Start of the record, nullptr for an empty view
+         * @param end    End of the buffer the record is in
+         */
+        DataTagView(const char* record = nullptr, const char* end = nullptr);
+
+        std::string_view balance() const { return string(0); }
+        std::string_view factor()  const { return string(1); }
+        std::string_view id()      const { return string(2); }
+        std::string_view name()    const { return string(3); }
+        std::string_view parent()  const { return string(4); }
+        std::string_view tag()     const { return string(5); }
+        std::string_view unit()    const { return string(6); }
+
+        int   sequence() const;
+        float value()    const;
+
+        /**
+         * @brief Start of the record in the file.
+         */
+        const char* data() const { return record; }
+
+        /**
+         * @brief Skips over a record without decoding it.
+         *
+         * @param record        Start of a DataTag record
+         * @param end           End of the buffer the record is in
+         * @return const char*  Start of the record after it, nullptr if it runs past the end
+         */
+        static const char* skip(const char* record, const char* end);
+
+    private:
+        std::string_view string(c_uint index) const;
+        void decode() const;
+
+        const char* record;
+        const char* end;
+
+        mutable bool             decoded;
+        mutable std::string_view strings[schema::model<DataTag>::layout::strings];
+        mutable int              sequence_;
+        mutable float            value_;
+    };
+
+    /**
+     * @brief View of every DataTag record in a DataTag file of any version.
+     */
+    class DataTagListView
+    {
+    public:
+        class iterator
+        {
+        public:
+            iterator(const char* record, const char* end, c_uint index, c_uint count) :
+                record(record), end(end), index(index), count(count)
+                { measure(); }
+
+            DataTagView operator*() const { return DataTagView(record, end); }
+
+            iterator& operator++()
+                { record = next; index++; measure(); return *this; }
+
+            bool operator!=(const iterator& other) const { return index != other.index; }
+            bool operator==(const iterator& other) const { return index == other.index; }
+
+        private:
+            // Finds the record after this one, a record that runs past the end ends the walk
+            void measure()
+            {
+                next = (index < count ? DataTagView::skip(record, end) : nullptr);
+                if (!next) index = count;
+            }
+
+            const char*  record;
+            const char*  next;
+            const char*  end;
+            unsigned int index;
+            unsigned int count;
+        };
+
+        DataTagListView(const Cloud::File* file);
+        DataTagListView(const char* data, c_uint size);
+
+        /**
+         * @brief Whether the buffer starts with the DataTag magic number.
+         */
+        bool valid() const;
+
+        /**
+         * @brief Amount of records the file declares, a cut off file holds fewer.
+         */
+        unsigned int size() const;
+
+        /**
+         * @brief Random access to a record.
+         *
+         * v2 files carry an offset table. For v1 files the first call walks every record once
+         * to build one. A record that isn't in the buffer, or an offset pointing outside of
+         * it, gives an empty view.
+         */
+        DataTagView operator[](c_uint index) const;
+
+        /**
+         * @brief Whether the file carries an offset table, making operator[] constant time.
+         */
+        bool offset_table() const { return table != nullptr; }
+
+        /**
+         * @brief Whether the file carries a tag index, see Format.h.
+         */
+        bool indexed() const { return index != nullptr; }
+
+        /**
+         * @brief Looks up the first record with a given tag.
+         *
+         * A binary search over the tag index if the file has one, a scan otherwise.
+         *
+         * @param tag           Tag to look for
+         * @return unsigned int Number of the record, size() if there is none
+         */
+        unsigned int find(std::string_view tag) const;
+
+        iterator begin() const { return iterator(first, limit, 0, count); }
+        iterator end()   const { return iterator(nullptr, limit, count, count); }
+
+    private:
+        const char*  data;
+        const char*  first;
+        unsigned int count;
+        bool         magic;
+
+        // End of the buffer
+        const char*  limit;
+
+        // Offset table and tag index of v2 files
+        const char*  table;
+        const char*  index;
+
+        mutable std::vector<const char*> offsets;
+    };
+
+    /**
+     * @brief View of the Statement stored in a Statement file.
+     */
+    class StatementView
+    {
+    public:
+        StatementView(const Cloud::File* file);
+        StatementView(const char* data, c_uint size);
+
+        bool valid() const;
+
+        std::string_view end_date()       const { return string(0); }
+        std::string_view filing_date()    const { return string(1); }
+        std::string_view fiscal_period()  const { return string(2); }
+        std::string_view id()             const { return string(3); }
+        std::string_view start_date()     const { return string(4); }
+        std::string_view statement_code() const { return string(5); }
+        std::string_view type()           const { return string(6); }
+
+        int fiscal_year() const;
+
+    private:
+        std::string_view string(c_uint index) const;
+        void decode() const;
+
+        const char* data;
+        const char* end;
+        bool        magic;
+
+        mutable bool             decoded;
+        mutable std::string_view strings[schema::model<Statement>::layout::strings];
+        mutable int              fiscal_year_;
+    };
+
+    /**
+     * @brief View of the Company stored in a Company file.
+     */
+    class CompanyView
+    {
+    public:
+        CompanyView(const Cloud::File* file);
+        CompanyView(const char* data, c_uint size);
+
+        bool valid() const;
+
+        std::string_view cik()    const { return string(0); }
+        std::string_view id()     const { return string(1); }
+        std::string_view lei()    const { return string(2); }
+        std::string_view name()   const { return string(3); }
+        std::string_view ticker() const { return string(4); }
+
+    private:
+        std::string_view string(c_uint index) const;
+        void decode() const;
+
+        const char* data;
+        const char* end;
+        bool        magic;
+
+        mutable bool             decoded;
+        mutable std::string_view strings[schema::model<Company>::layout::strings];
+    };
+}
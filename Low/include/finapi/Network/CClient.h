@@ -14,28 +14,22 @@
 #pragma once
 
 #include "Network.h"
+#include "../Core/ThreadPool.h"
+#include "../Core/ByteSource.h"
+#include "../Core/MappedFile.h"
+#include "../Core/Compress.h"
 
-#ifdef _FIN_DEBUG
+// Default amount of threads downloading chunks, matches the default per-address pool size
+#define _FIN_DOWNLOAD_WORKERS 16
 
-#   include <iostream>
-#   include <chrono>
+// Amount of times a failed chunk is tried again before the download gives up
+#define _FIN_CHUNK_RETRIES 3
 
-#   define time_p std::chrono::_V2::system_clock::time_point
-#   define time_point(name) time_p name = std::chrono::high_resolution_clock::now();
-#   define logtime_msg(msg, time, post) std::cout << msg << \
-    std::chrono::duration_cast<time>(stop - start).count() << post << "\n"
+// Default amount of chunks requested at once in pipelined mode
+#define _FIN_PIPELINE_DEPTH 64
 
-#define logmsg_ms(msg) logtime_msg(msg, std::chrono::milliseconds, " ms")
-#define logmsg_micros(msg) logtime_msg(msg, std::chrono::microseconds, " micros")
-
-#else
-
-//  Define the macros as empty so they can be used irreplaceably
-#   define time_point(...)
-#   define logmsg_micros(...)
-#   define logmsg_ms(...)
-
-#endif
+// Amount of sessions get_files() spreads the metadata queries of a batch over
+#define _FIN_METADATA_SESSIONS 4
 
 namespace finapi
 {
@@ -64,9 +58,47 @@ namespace _ADDR
         EMPTY,
         SOCKET_FAIL,
         CONNECT_FAIL,
-        LOGIN_FAIL
+        LOGIN_FAIL,
+        PARTIAL
+    };
+
+    /**
+     * @brief Process-wide settings for how files are transferred.
+     */
+    struct Options
+    {
+        /**
+         * @brief Request chunks in ranges rather than one by one.
+         * 
+         * Each session sends a single `REQ <file> <first> <count>` and reads the chunks back
+         * to back, instead of paying a round trip for every chunk. The server has to support
+         * the ranged form of REQ.
+         */
+        bool pipelined = false;
+
+        /**
+         * @brief Amount of chunks per ranged request in pipelined mode.
+         */
+        unsigned int pipeline_depth = _FIN_PIPELINE_DEPTH;
+
+        /**
+         * @brief Ask for compressed chunk replies on every new session.
+         * 
+         * Right after logging in a session sends `COMPRESS`. If the server answers `OK`, each
+         * chunk of a REQ reply on that session comes back as an independent block, see
+         * Compress.h. Sessions the server declines keep receiving raw chunks. Only enable
+         * this against servers that answer unknown commands.
+         */
+        bool compressed = false;
     };
 
+    /**
+     * @brief Access the transfer settings, these should be set before any download starts.
+     * 
+     * @return Options& Process-wide settings
+     */
+    Options& options();
+
     struct File
     {
         Status status;
@@ -77,23 +109,122 @@ namespace _ADDR
 
         File(c_uint size);
 
+        /**
+         * @brief Copies the next bytes of the file out.
+         * 
+         * While the file is still streaming in, this blocks until every byte up to the end
+         * of the read has arrived. If the download fails first the missing bytes read as
+         * zero and the status is set. A read past the end of the file is cut off the same
+         * way and sets the status to PARTIAL.
+         */
         void read(void* ptr, c_uint size);
 
+        /**
+         * @brief Points at the next bytes of the buffer in place and moves past them.
+         * 
+         * Waits like read(). A span past the end of the file sets the status to PARTIAL and
+         * leaves the file at its end.
+         * 
+         * @return const char* Start of the bytes, nullptr if the file ends before them
+         */
+        const char* read_span(c_uint size);
+
+        /**
+         * @brief Reads an array of little endian numbers with a single bounds check.
+         * 
+         * @return bool Whether all of them were in the file, missing ones read as zero
+         */
+        template<typename T>
+        bool read_array(T* dest, c_uint count)
+        {
+            const bool whole = (count * sizeof(T) <= filesize - iterator);
+            read(dest, count * sizeof(T));
+            endian::little(dest, count);
+            return whole;
+        }
+
+        /**
+         * @brief Moves past bytes of the file without copying them out, checked like read_span().
+         */
+        void skip(c_uint size);
+
+        /**
+         * @brief Amount of bytes of the file past the current position, arrived or not.
+         */
+        unsigned int remaining() const
+            { return filesize - iterator; }
+
+        /**
+         * @brief Cursor over the part of the buffer that hasn't been read yet.
+         * 
+         * Waits for a streaming download to finish first.
+         * 
+         * @return ByteSource Source that can be handed to any deserializer
+         */
+        ByteSource source();
+
+        /**
+         * @brief Amount of bytes from the start of the file that have arrived so far.
+         */
+        unsigned int available() const;
+
+        /**
+         * @brief Blocks until a streaming download has finished, successful or not.
+         */
+        void wait();
+
         ~File();
     
     private:
+        friend void stream_file(const char*, const char*, File*&);
+        friend std::vector<Status> get_files(const std::vector<std::string>&, const char*, std::unordered_map<std::string, File*>&);
+        friend class DiskCache;
+
+        struct download;
+
+        /**
+         * @brief Serves a file whose size is known from the disk cache or starts downloading it.
+         */
+        static void begin(File*& file, const char* filename, const char* address, c_uint filesize, c_uint chunks);
+
+        /**
+         * @brief File served from a local mapping, buffer points into it and is read-only.
+         */
+        File(MappedFile* mapping, c_uint offset, c_uint size);
+
         unsigned int iterator;
+        download*    stream;
+        MappedFile*  mapping;
+
+        void wait_for(c_uint end);
     };
 
     /**
      * @brief Make a request to the server with a given command.
      * 
+     * The reply is read with a single recv and the buffer isn't cleared beforehand, so only
+     * the returned amount of bytes is valid. Use request_frame() when the reply length is known.
+     * 
      * @param command   Command to send to the server
      * @param socket    Socket of the server
      * @param buffer    Location of the buffer to populate
      * @param size      Bytesize of the given buffer
+     * @return int      Amount of bytes received, zero or less if the request failed
      */
-    void make_request(const char* command, const int socket, char* buffer, int size = -1);
+    int make_request(const char* command, const int socket, char* buffer, int size = -1);
+
+    /**
+     * @brief Make a request whose reply has a known length.
+     * 
+     * The reply is received straight into the destination until all of it has arrived.
+     * 
+     * @param command   Command to send to the server
+     * @param socket    Socket of the server
+     * @param dest      Where the reply is written to
+     * @param size      Length of the reply
+     * @return Status   OK, SOCKET_FAIL if nothing came back or PARTIAL if the reply was cut short
+     */
+    Status request_frame(const char* command, const int socket, char* dest, const int size);
 
     /**
      * @brief Make a request with a given socket.
@@ -107,6 +238,8 @@ namespace _ADDR
     /**
      * @brief Make a request with a given address.
      * 
+     * The request is sent over a pooled connection, see Pool.h.
+     * 
      * @param command       Command to send to the server
      * @param address       Address of the server
      * @return std::string  Response given by the server
@@ -122,6 +255,17 @@ namespace _ADDR
      */
     bool file_exists(const char* filename, const char* address);
 
+    /**
+     * @brief Query whether a file exists and how it is split up on the server.
+     * 
+     * @param filename  Name of the file to query
+     * @param address   IP Address of the server
+     * @param filesize  Populated with the size of the file
+     * @param chunks    Populated with the amount of chunks the file is served in
+     * @return Status   OK when both values were populated
+     */
+    Status file_info(const char* filename, const char* address, unsigned int& filesize, unsigned int& chunks);
+
     /**
      * @brief Create a socket solely for the purpose of pulling a file from the server
      * 
@@ -130,11 +274,87 @@ namespace _ADDR
      * @param filesize  Size of the file
      * @param buffer    Location of the buffer to populate       
      * @param address   IP Address of the server
+     * @return Status   OK once the whole chunk has been received
+     */
+    Status request_file(const char* filename, const int i, const int filesize, char* buffer, const char* address);
+
+    /**
+     * @brief Pull a range of chunks from the server over one logged in session.
+     * 
+     * @param filename  Name of the file to pull
+     * @param first     Index of the first chunk in the range
+     * @param count     Amount of chunks in the range
+     * @param filesize  Size of the file
+     * @param buffer    Location of the buffer to populate
+     * @param address   IP Address of the server
+     * @param completed Populated with the amount of chunks received in full
+     * @return Status   OK once the whole range has been received
      */
-    void request_file(const char* filename, const int i, const int filesize, char* buffer, const char* address);
+    Status request_range(const char* filename, const int first, const int count, const int filesize, char* buffer, const char* address, int* completed = nullptr);
     
+    /**
+     * @brief Executor shared by every download in the process.
+     * 
+     * The threads are created on first use and live until the program exits.
+     * 
+     * @return ThreadPool& Download executor
+     */
+    ThreadPool& downloads();
+
+    /**
+     * @brief Changes the amount of threads used to download chunks.
+     * 
+     * Must not be called from within a download.
+     * 
+     * @param workers Amount of threads, zero restores the default
+     */
+    void set_download_workers(c_uint workers);
+
+    /**
+     * @brief Starts pulling a file and returns as soon as its size is known.
+     * 
+     * The chunks are downloaded on the download executor while the caller already reads
+     * the file: File::read() only waits for the bytes it needs, so a deserializer can work
+     * through the first records while the rest is still arriving.
+     * 
+     * A current copy in the disk cache (see Cache.h) is served without pulling any chunks,
+     * and a completed download is stored there.
+     * 
+     * @param filename  Name of the file to pull
+     * @param address   IP Address of the server
+     * @param file      Populated with a newly allocated file, check its status
+     */
+    void stream_file(const char* filename, const char* address, File*& file);
+
+    /**
+     * @brief Pulls a whole file from the server.
+     * 
+     * The chunks are downloaded in parallel on the download executor. When the disk cache
+     * is configured and holds a current copy, the file is served from there instead.
+     * 
+     * @param filename  Name of the file to pull
+     * @param address   IP Address of the server
+     * @param file      Populated with a newly allocated file, check its status
+     */
     void get_file(const char* filename, const char* address, File*& file);
 
     void get_file(const char* filename, Address address, File*& file);
+
+    /**
+     * @brief Pulls a batch of files, such as everything that makes up one company.
+     * 
+     * Repeated names are pulled once. The exists, SZE and CHK queries of the whole batch
+     * share a few pooled sessions instead of costing a handshake per file, and the chunks
+     * of every file go through the download executor together. Must not be called from
+     * within a download.
+     * 
+     * @param filenames Names of the files to pull
+     * @param address   IP Address of the server
+     * @param files     Populated with one newly allocated file per distinct name. A name
+     *                  already holding a file keeps it and is only waited on, one holding
+     *                  nullptr is pulled
+     * @return std::vector<Status> Status of each requested name, in the order given
+     */
+    std::vector<Status> get_files(const std::vector<std::string>& filenames, const char* address, std::unordered_map<std::string, File*>& files);
 }
 }
\ No newline at end of file
@@ -0,0 +1,131 @@
+/**
+ * @file Cache.h
+ *
+ * @brief Local on-disk cache of downloaded files.
+ *
+ * get_file consults the cache before pulling any chunks. An entry is only used when the
+ * size and chunk count the server reports still match what was stored, and is then served
+ * straight from a memory mapping of the cached copy. Entries may also be stored as blocks of
+ * the transfer codec (Compress.h), trading the mapping for a decode on every hit.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-21
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "CClient.h"
+#include "../Core/MappedFile.h"
+
+// Default disk budget of the cache, in bytes
+#define _FIN_CACHE_BUDGET 1024ull*1024*1024
+
+// Bytes of a file per block in compressed entries
+#define _FIN_CACHE_BLOCK 64*1024
+
+// Seconds after which a temporary left in the directory counts as an interrupted store
+#define _FIN_CACHE_STALE 60*60
+
+namespace finapi
+{
+namespace Cloud
+{
+    class DiskCache
+    {
+    public:
+        DiskCache();
+
+        /**
+         * @brief Points the cache at a directory, creating it if needed.
+         *
+         * The entries already in the directory are picked up and count towards the budget,
+         * temporaries that stores interrupted long ago left behind are removed.
+         *
+         * @param directory Where the entries are stored, empty disables the cache
+         * @param budget    Bytes the entries may take up before the least recently used go
+         * @param compress  Whether new entries are stored compressed, existing ones are read either way
+         */
+        void configure(const std::string& directory, const unsigned long long budget = _FIN_CACHE_BUDGET, const bool compress = false);
+
+        bool enabled();
+
+        /**
+         * @brief Looks up a file and serves it from disk if it is still current.
+         *
+         * @param address   IP Address of the server the file comes from
+         * @param filename  Name of the file
+         * @param filesize  Size the server reports for the file
+         * @param chunks    Chunk count the server reports for the file
+         * @return File*    Newly allocated file backed by the cached copy, nullptr on a miss
+         */
+        File* lookup(const char* address, const char* filename, c_uint filesize, c_uint chunks);
+
+        /**
+         * @brief Stores a completely downloaded file.
+         *
+         * The entry is written to a temporary file and renamed into place, so a reader
+         * never sees a half written entry.
+         */
+        void store(const char* address, const char* filename, const char* buffer, c_uint filesize, c_uint chunks);
+
+        /**
+         * @brief Removes every entry.
+         */
+        void clear();
+
+        /**
+         * @brief Bytes currently taken up by the entries.
+         */
+        unsigned long long size();
+
+    private:
+        // Stored little endian field by field, see Endian.h
+        struct header
+        {
+            char         magic[4];
+            unsigned int filesize;
+            unsigned int chunks;
+            unsigned int flags;
+        };
+
+        // The file follows the header as a sequence of blocks rather than as is
+        static const unsigned int COMPRESSED = 1;
+
+        struct entry
+        {
+            unsigned long long size;
+
+            // Modification time of the entry, bumped on every hit so the order survives restarts
+            long long          last_used;
+        };
+
+        std::string path(const char* address, const char* filename) const;
+
+        /**
+         * @brief Unpacks the blocks of a compressed entry into a new file, nullptr if they are broken.
+         */
+        static File* unpack(const MappedFile& mapping, c_uint filesize);
+
+        /**
+         * @brief Drops the least recently used entries until the budget is met, mutex must be held.
+         */
+        void evict();
+
+        std::mutex                             mutex;
+        std::string                            directory;
+        unsigned long long                     budget;
+        unsigned long long                     total;
+        bool                                   compress;
+        std::unordered_map<std::string, entry> entries;
+    };
+
+    /**
+     * @brief Cache consulted by get_file, disabled until configured.
+     */
+    DiskCache& cache();
+}
+}
@@ -22,7 +22,7 @@
 #   include <WS2tcpip.h> // For WSA
 
 #   define _FIN_WINDOWS
-#   define SOCK_OPT SO_REUSEADDR // Tedious differences in the OS-specific libraries
+#   define _FIN_SEND_FLAGS 0
 
 /*     FUNCTION DEFINITIONS     */
 
@@ -67,7 +67,12 @@ namespace network
 #   include <arpa/inet.h>  // inet function
 #   include <unistd.h>     // close
 
-#   define SOCK_OPT SO_REUSEADDR | SO_REUSEPORT
+// Don't let a server hanging up mid-send kill the process with SIGPIPE
+#   ifdef MSG_NOSIGNAL
+#       define _FIN_SEND_FLAGS MSG_NOSIGNAL
+#   else
+#       define _FIN_SEND_FLAGS 0
+#   endif
 
 /*     FUNCTION DEFINITIONS     */
 namespace finapi
@@ -81,7 +86,22 @@ namespace network
 #endif
 
 // Buffer size to expect from the server
-#define _FIN_BUFFER_SIZE 1024*2
+#define _FIN_BUFFER_SIZE (1024*2)
+
+// Port the server listens on
+#define _FIN_PORT 1420
+
+// Kernel receive buffer of a client socket, room for a whole pipelined range of chunks
+#define _FIN_RECV_BUFFER (_FIN_BUFFER_SIZE * 64)
+
+// Kernel send buffer of a client socket, the commands are a few bytes each
+#define _FIN_SEND_BUFFER (_FIN_BUFFER_SIZE)
+
+// Milliseconds a connection may take to be set up
+#define _FIN_CONNECT_TIMEOUT 5000
+
+// Milliseconds a single send or receive may block
+#define _FIN_IO_TIMEOUT 30000
 
 #include "../Core/Core.h"
 
@@ -122,13 +142,50 @@ namespace network
     int make_socket();
 
     /**
-     * @brief Sets the basic options of a given socket.
+     * @brief Settings every client socket is set up with.
+     */
+    struct Transport
+    {
+        // Send every command as soon as it's written instead of holding it back to be
+        // coalesced (TCP_NODELAY), the protocol never has more than one in flight anyway
+        bool         no_delay        = true;
+
+        // Let the kernel probe connections sitting idle in the pool (SO_KEEPALIVE)
+        bool         keep_alive      = true;
+
+        // SO_RCVBUF and SO_SNDBUF in bytes, zero leaves the sizing to the system
+        int          receive_buffer  = _FIN_RECV_BUFFER;
+        int          send_buffer     = _FIN_SEND_BUFFER;
+
+        // Deadlines in milliseconds, zero waits for as long as it takes
+        unsigned int connect_timeout = _FIN_CONNECT_TIMEOUT;
+        unsigned int send_timeout    = _FIN_IO_TIMEOUT;
+        unsigned int recv_timeout    = _FIN_IO_TIMEOUT;
+    };
+
+    /**
+     * @brief Access the transport settings, these should be set before any connection is made.
+     * 
+     * @return Transport& Process-wide settings
+     */
+    Transport& transport();
+
+    /**
+     * @brief Sets the options of a listening socket, so it can be bound again right away.
      * 
      * @param sock Integer handle for the socket.
      * @return int Execution state: 0 for failed, 1 for success
      */
     int set_options(const int sock);
 
+    /**
+     * @brief Applies the transport settings to a client socket.
+     * 
+     * @param sock Integer handle for the socket.
+     * @return int Execution state: 0 if any option was refused, the socket still works then
+     */
+    int tune_socket(const int sock);
+
     /**
      * @brief Binds a port to a given socket.
      * 
@@ -157,9 +214,24 @@ namespace network
      */
     int accept_socket(const int sock, sockaddr_in* in, int* addr_len);
 
+    /**
+     * @brief Fills in the socket address of an "ip" or "ip:port" string.
+     * 
+     * Addresses without a port use _FIN_PORT, so a stand-in server can listen anywhere
+     * while the regular addresses keep working unchanged.
+     * 
+     * @param address   String of the IP, optionally followed by a port
+     * @param dest      Populated with the IPv4 address and port
+     * @return int      Success value
+     */
+    int parse_address(const char* address, sockaddr_in* dest);
+
     /**
      * @brief Client side function for connecting to a given IP.
      * 
+     * The kernel picks the local port. The connection is made without blocking and given
+     * up on once the connect timeout of the transport settings has passed.
+     * 
      * @param sock  Client's socket handle
      * @param ip    String of an IP to connect to
      * @param port  Port to connect to
@@ -167,10 +239,30 @@ namespace network
      */
     int connect_to_ip(const int sock, const char* ip, const int port);
 
+    /**
+     * @brief Sends an entire buffer, looping over partial sends.
+     * 
+     * @param sock  Socket handle
+     * @param data  Bytes to send
+     * @param size  Amount of bytes to send
+     * @return int  Success value
+     */
+    int send_all(const int sock, const char* data, const int size);
+
+    /**
+     * @brief Receives exactly size bytes straight into the destination.
+     * 
+     * @param sock  Socket handle
+     * @param dest  Where the bytes are written to
+     * @param size  Amount of bytes expected
+     * @return int  Amount of bytes received, less than size if the connection failed or closed early
+     */
+    int recv_all(const int sock, char* dest, const int size);
+
     /**
      * @brief Method for easily connecting to a given IP address.
      * 
-     * @param address   String of the IP to connect to
+     * @param address   String of the IP to connect to, optionally followed by a port
      * @return int      Created socket for connection
      */
     int connect_socket(const char* address);
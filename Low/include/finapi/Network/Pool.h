@@ -0,0 +1,142 @@
+/**
+ * @file Pool.h
+ *
+ * @brief Pool of warm, authenticated connections to the cloud server.
+ *
+ * Every Cloud:: entry point used to open a brand new socket, bind it, connect it and
+ * log in before sending a single command. The pool keeps those sockets around after
+ * use, keyed on the address they're connected to, so the next request can skip straight
+ * to sending its command.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-04
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "CClient.h"
+
+namespace finapi
+{
+namespace Cloud
+{
+    /**
+     * @brief Thread-safe per-address pool of logged in sockets.
+     *
+     * A socket is taken out of the pool with checkout() and must be handed back with either
+     * checkin() (the socket is still in a known state) or discard() (a request failed on it
+     * and the connection can't be trusted anymore).
+     */
+    class ConnectionPool
+    {
+    public:
+        /**
+         * @param max_size      Maximum amount of open sockets per address
+         * @param idle_seconds  Seconds an unused socket is kept before being closed
+         */
+        ConnectionPool(c_uint max_size = 16, c_uint idle_seconds = 30);
+        ~ConnectionPool();
+
+        /**
+         * @brief Take a connected and logged in socket out of the pool.
+         *
+         * Reuses an idle socket when a healthy one is available, otherwise opens a new one
+         * unless the address is already at its limit, in which case this blocks until another
+         * thread returns a socket.
+         *
+         * @param address   IP address of the server
+         * @param socket    Populated with the socket handle on success
+         * @return Status   OK, SOCKET_FAIL, CONNECT_FAIL or LOGIN_FAIL
+         */
+        Status checkout(const char* address, int& socket);
+
+        /**
+         * @brief Return a socket that is still usable to the pool.
+         *
+         * @param address   Address the socket was checked out with
+         * @param socket    Socket handle
+         */
+        void checkin(const char* address, const int socket);
+
+        /**
+         * @brief Close a socket that was checked out and release its slot.
+         *
+         * @param address   Address the socket was checked out with
+         * @param socket    Socket handle
+         */
+        void discard(const char* address, const int socket);
+
+        /**
+         * @brief Close every idle socket that has been unused for longer than the idle timeout.
+         */
+        void evict_idle();
+
+        /**
+         * @brief Close every idle socket regardless of age.
+         */
+        void clear();
+
+        void set_max_size(c_uint max_size);
+        void set_idle_timeout(c_uint seconds);
+
+        unsigned int idle_count(const char* address);
+        unsigned int open_count(const char* address);
+
+        /**
+         * @brief Whether the server agreed to send compressed chunks over a checked out socket.
+         */
+        bool compressed(const int socket);
+
+    private:
+        typedef std::chrono::steady_clock clock;
+
+        struct connection
+        {
+            int               socket;
+            clock::time_point last_used;
+        };
+
+        struct endpoint
+        {
+            std::vector<connection> idle;
+            unsigned int            open = 0;
+        };
+
+        /**
+         * @brief Closes the idle sockets of an endpoint that are past the timeout.
+         *
+         * The pool mutex must be held.
+         */
+        void evict(endpoint& ep, const clock::time_point now);
+
+        /**
+         * @brief Closes a socket and forgets what was negotiated on it, the pool mutex must be held.
+         */
+        void close_socket(const int socket);
+
+        /**
+         * @brief Checks whether an idle socket is still connected and has no stray data waiting.
+         */
+        static bool healthy(const int socket);
+
+        std::mutex                                mutex;
+        std::condition_variable                   returned;
+        std::unordered_map<std::string, endpoint> endpoints;
+
+        // Open sockets that negotiated compressed replies
+        std::unordered_map<int, bool>             compressing;
+
+        unsigned int              max_size;
+        std::chrono::seconds      idle_timeout;
+    };
+
+    /**
+     * @brief Process-wide pool used by every Cloud:: request.
+     */
+    ConnectionPool& pool();
+}
+}
@@ -0,0 +1,140 @@
+/**
+ * @file Reactor.h
+ *
+ * @brief Event driven transport that multiplexes chunk downloads over non-blocking sockets.
+ *
+ * Cloud::get_file blocks a worker per chunk for the full round trip. The reactor instead
+ * runs a single thread on top of epoll that drives every chunk socket of every file at
+ * once, so thousands of chunks can be in flight without a thread for each of them.
+ *
+ * Only available on Linux, where _FIN_REACTOR is defined.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-07
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "CClient.h"
+
+#if defined(__linux__)
+#   define _FIN_REACTOR
+#endif
+
+// Default amount of sockets a single file is downloaded over
+#define _FIN_REACTOR_CONNECTIONS 8
+
+// Default amount of sockets the reactor keeps open across every file
+#define _FIN_REACTOR_MAX_CONNECTIONS 512
+
+#ifdef _FIN_REACTOR
+
+namespace finapi
+{
+namespace Cloud
+{
+    /**
+     * @brief Called on the reactor thread once a file has finished downloading.
+     *
+     * The callback takes ownership of the file. It should be short, since no other
+     * download makes progress while it runs.
+     */
+    typedef std::function<void(File*)> file_callback;
+
+    class Reactor
+    {
+    public:
+        /**
+         * @param connections       Amount of sockets used per file
+         * @param max_connections   Amount of sockets open at once across every file
+         */
+        Reactor(c_uint connections = _FIN_REACTOR_CONNECTIONS, c_uint max_connections = _FIN_REACTOR_MAX_CONNECTIONS);
+        ~Reactor();
+
+        /**
+         * @brief Starts downloading a file and returns immediately.
+         *
+         * The size of the file is queried on the calling thread, so this blocks for those
+         * round trips, the chunks are then pulled by the reactor thread. The callback is
+         * invoked on the reactor thread with the finished file, or with a file holding the
+         * failure status, a failed query included.
+         *
+         * @param filename  Name of the file to pull
+         * @param address   IP Address of the server
+         * @param callback  Receives the file once it has been downloaded
+         */
+        void get_file(const char* filename, const char* address, file_callback callback);
+
+        /**
+         * @brief Starts downloading a file and returns a future for it.
+         *
+         * @param filename              Name of the file to pull
+         * @param address               IP Address of the server
+         * @return std::future<File*>   Resolves to the downloaded file, which the caller owns
+         */
+        std::future<File*> get_file(const char* filename, const char* address);
+
+        /**
+         * @brief Amount of files currently being downloaded.
+         */
+        unsigned int active();
+
+    private:
+        struct download;
+        struct connection;
+
+        void run();
+
+        /**
+         * @brief Frees the connections closed during the last batch of events and invokes
+         *        the callbacks of the downloads that finished in it.
+         */
+        void collect();
+
+        void start(download* dl);
+        void open_connections(download* dl);
+        bool open_connection(download* dl);
+        void close_connection(connection* c);
+
+        void on_writable(connection* c);
+        void on_readable(connection* c);
+        void send_pending(connection* c);
+        void next_chunk(connection* c);
+        void fail(connection* c, const Status status);
+        void finish(download* dl, const Status status);
+
+        void watch(connection* c, const unsigned int events, const bool add = false);
+
+        const unsigned int connections;
+        const unsigned int max_connections;
+
+        int poll_fd;
+        int wake_fd;
+
+        std::mutex              incoming_mutex;
+        std::vector<download*>  incoming;
+
+        // Only touched by the reactor thread
+        std::vector<download*>  downloads;
+        std::deque<download*>   starved;
+        std::vector<connection*> closed;
+        std::vector<download*>  done;
+        unsigned int            open;
+
+        std::atomic<unsigned>   in_flight;
+        std::atomic<bool>       stopping;
+        std::thread             thread;
+    };
+
+    /**
+     * @brief Process-wide reactor, started on first use.
+     */
+    Reactor& reactor();
+}
+}
+
+#endif
@@ -19,19 +19,61 @@
 #pragma once
 
 /*      Sys. Includes       */
-#include <cassert>  // assert
-#include <fstream>  // ifstream, ofstream
-#include <vector>   // vector class
-#include <thread>   // thread class
-#include <cstdlib>  // malloc, free
-#include <string>   // string class
-#include <cstring>  // memset
+#include <cassert>             // assert
+#include <fstream>             // ifstream, ofstream
+#include <vector>              // vector class
+#include <thread>              // thread class
+#include <cstdlib>             // malloc, free
+#include <string>              // string class
+#include <cstring>             // memset
+#include <algorithm>           // min, max
+#include <numeric>             // iota
+#include <chrono>              // steady_clock
+#include <mutex>               // mutex, lock_guard
+#include <condition_variable>  // condition_variable
+#include <unordered_map>       // unordered_map
+#include <deque>               // deque
+#include <list>                // list
+#include <atomic>              // atomic
+#include <functional>          // function
+#include <future>              // future, promise
+#include <memory>              // shared_ptr
+#include <new>                 // placement new
+#include <cstddef>             // size_t, max_align_t
+#include <cstdint>             // uintptr_t
+#include <climits>             // INT_MAX, UINT_MAX
+#include <string_view>         // string_view
+#include <filesystem>          // directory_iterator, rename
+#include <type_traits>         // is_same
+#include <utility>             // index_sequence
+
+#ifdef _MSC_VER
+#include <intrin.h>            // _BitScanReverse64
+#endif
+
+/*           Core           */
+#include "Core/Core.h"
+#include "Core/ThreadPool.h"
+#include "Core/Arena.h"
+#include "Core/Intern.h"
+#include "Core/ByteSource.h"
+#include "Core/ByteSink.h"
+#include "Core/MappedFile.h"
+#include "Core/Metrics.h"
+#include "Core/Trace.h"
 
 /*          Network         */
 #include "Network/Network.h"
 #include "Network/CClient.h"
+#include "Network/Pool.h"
+#include "Network/Reactor.h"
+#include "Network/Cache.h"
 
 /*          Models          */
 #include "Models/Company.h"
 #include "Models/DataTag.h" 
-#include "Models/Statement.h" 
+#include "Models/Statement.h"
+#include "Models/Format.h"
+#include "Models/View.h"
+#include "Models/DataTagTable.h"
+#include "Models/ModelCache.h" 
@@ -0,0 +1,71 @@
+#include "finapi/finapi.h"
+
+namespace finapi
+{
+    Arena::Arena(c_uint block_size) :
+        head(nullptr), cursor(nullptr), end(nullptr),
+        block_size(block_size ? block_size : _FIN_ARENA_BLOCK), next_size(this->block_size),
+        bytes(0), count(0)
+    {   }
+
+    Arena::~Arena()
+    {
+        release();
+    }
+
+    void* Arena::allocate(const std::size_t size, const std::size_t align)
+    {
+        char* aligned = (char*)(((std::uintptr_t)cursor + align - 1) & ~(std::uintptr_t)(align - 1));
+
+        if (!cursor || aligned + size > end)
+        {
+            // Grab a new block big enough for the request, doubling each time so that
+            // large documents only end up with a few blocks
+            const std::size_t header = (sizeof(block) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+            std::size_t capacity = next_size;
+            while (capacity < size + align) capacity *= 2;
+            next_size = capacity * 2;
+
+            block* b = (block*)std::malloc(header + capacity);
+            b->next  = head;
+            b->size  = capacity;
+            head     = b;
+            count++;
+
+            cursor  = (char*)b + header;
+            end     = cursor + capacity;
+            aligned = (char*)(((std::uintptr_t)cursor + align - 1) & ~(std::uintptr_t)(align - 1));
+        }
+
+        cursor = aligned + size;
+        bytes += size;
+        return aligned;
+    }
+
+    void Arena::release()
+    {
+        while (head)
+        {
+            block* next = head->next;
+            std::free(head);
+            head = next;
+        }
+
+        cursor    = nullptr;
+        end       = nullptr;
+        next_size = block_size;
+        bytes     = 0;
+        count     = 0;
+    }
+
+    std::size_t Arena::used() const
+    {
+        return bytes;
+    }
+
+    unsigned int Arena::blocks() const
+    {
+        return count;
+    }
+}
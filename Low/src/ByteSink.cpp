@@ -0,0 +1,39 @@
+#include "finapi/finapi.h"
+
+namespace finapi
+{
+    ByteSink::ByteSink(std::ostream* out, c_uint capacity) :
+        out(out), buffer(std::max(capacity, 1u)), used(0)
+    {   }
+
+    ByteSink::~ByteSink()
+    {
+        flush();
+    }
+
+    void ByteSink::flush()
+    {
+        if (!out || !used) return;
+
+        out->write(buffer.data(), used);
+        used = 0;
+    }
+
+    bool ByteSink::good() const
+    {
+        return (!out || out->good());
+    }
+
+    void ByteSink::make_room(c_uint size)
+    {
+        if (out)
+        {
+            flush();
+
+            // A write larger than the whole buffer goes through the buffer in one go anyway
+            if (size <= buffer.size()) return;
+        }
+
+        buffer.resize(std::max<std::size_t>(buffer.size() * 2, used + size));
+    }
+}
@@ -0,0 +1,313 @@
+#include "finapi/finapi.h"
+
+namespace fs = std::filesystem;
+
+// Marks a cache entry, followed by the layout version
+static const char cache_magic[4] = { 'F', 'I', 'N', '1' };
+
+namespace finapi
+{
+namespace Cloud
+{
+    static long long now()
+    {
+        return fs::file_time_type::clock::now().time_since_epoch().count();
+    }
+
+    DiskCache::DiskCache() :
+        budget(_FIN_CACHE_BUDGET), total(0), compress(false)
+    {   }
+
+    void DiskCache::configure(const std::string& dir, const unsigned long long limit, const bool compressed)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        directory = dir;
+        budget    = limit;
+        compress  = compressed;
+        total     = 0;
+        entries.clear();
+
+        if (directory.empty()) return;
+
+        std::error_code error;
+        fs::create_directories(directory, error);
+
+        // Another process sharing the directory may still be writing a fresh temporary
+        const fs::file_time_type stale = fs::file_time_type::clock::now() - std::chrono::seconds(_FIN_CACHE_STALE);
+
+        // Pick up what an earlier run left behind, temporaries of interrupted stores are removed
+        for (fs::directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+        {
+            if (!it->is_regular_file(error))
+                continue;
+
+            if (it->path().extension() == ".tmp")
+            {
+                std::error_code ignored;
+                if (it->last_write_time(ignored) < stale && !ignored)
+                    fs::remove(it->path(), ignored);
+                continue;
+            }
+
+            if (it->path().extension() != ".fin")
+                continue;
+
+            const unsigned long long size = it->file_size(error);
+            const long long          used = it->last_write_time(error).time_since_epoch().count();
+
+            if (error) { error.clear(); continue; }
+
+            entries[it->path().string()] = { size, used };
+            total += size;
+        }
+
+        evict();
+    }
+
+    bool DiskCache::enabled()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return !directory.empty();
+    }
+
+    std::string DiskCache::path(const char* address, const char* filename) const
+    {
+        // FNV-1a over the server and the name, filenames may hold characters paths can't
+        unsigned long long hash = 14695981039346656037ull;
+        for (const char* c = address;  *c; c++) hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+        hash = (hash ^ '\n') * 1099511628211ull;
+        for (const char* c = filename; *c; c++) hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+
+        char name[24];
+        std::snprintf(name, sizeof(name), "%016llx.fin", hash);
+        return (fs::path(directory) / name).string();
+    }
+
+    File* DiskCache::lookup(const char* address, const char* filename, c_uint filesize, c_uint chunks)
+    {
+        std::string location;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (directory.empty()) return nullptr;
+            location = path(address, filename);
+        }
+
+        MappedFile* mapping = new MappedFile(location.c_str());
+        if (!mapping->valid())
+            { delete mapping; return nullptr; }
+
+        // The server only offers the size and the chunk count to tell versions apart
+        header h;
+        bool current = (mapping->size() >= sizeof(header));
+        if (current)
+        {
+            // Entries are little endian, so a directory can be shared between machines
+            const char* stored = mapping->data();
+            std::memcpy(h.magic, stored, sizeof(h.magic));
+            h.filesize = endian::load<unsigned int>(stored + offsetof(header, filesize));
+            h.chunks   = endian::load<unsigned int>(stored + offsetof(header, chunks));
+            h.flags    = endian::load<unsigned int>(stored + offsetof(header, flags));
+            current = !std::memcmp(h.magic, cache_magic, sizeof(cache_magic)) && h.filesize == filesize && h.chunks == chunks &&
+                      ((h.flags & COMPRESSED) || mapping->size() == sizeof(header) + filesize + 1);
+        }
+
+        File* file = nullptr;
+        if (current)
+        {
+            if (h.flags & COMPRESSED)
+            {
+                // Compressed entries are decoded into a file of their own, the mapping isn't kept
+                file    = unpack(*mapping, filesize);
+                current = (file != nullptr);
+
+                delete mapping;
+                mapping = nullptr;
+            }
+            else
+                file = new File(mapping, sizeof(header), filesize);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (!current)
+        {
+            // A mapping stays valid after its file is removed, so stale entries can go right away
+            delete mapping;
+
+            std::error_code error;
+            fs::remove(location, error);
+
+            auto it = entries.find(location);
+            if (it != entries.end())
+                { total -= it->second.size; entries.erase(it); }
+
+            return nullptr;
+        }
+
+        const long long used = now();
+
+        std::error_code error;
+        fs::last_write_time(location, fs::file_time_type(fs::file_time_type::duration(used)), error);
+
+        auto it = entries.find(location);
+        if (it == entries.end())
+        {
+            // Written by another process sharing the directory
+            const unsigned long long size = fs::file_size(location, error);
+            if (!error)
+            {
+                entries[location] = { size, used };
+                total += size;
+                evict();
+            }
+        }
+        else it->second.last_used = used;
+
+        return file;
+    }
+
+    File* DiskCache::unpack(const MappedFile& mapping, c_uint filesize)
+    {
+        File* file = new File(filesize);
+
+        ByteSource source = mapping.source();
+        source.skip(sizeof(header));
+
+        unsigned int written = 0;
+        while (written < filesize)
+        {
+            if (source.remaining() < sizeof(compress::block_header)) break;
+
+            const compress::block_header block = compress::load_header(source.current());
+            source.skip(sizeof(block));
+
+            if (block.raw > filesize - written || block.size > source.remaining() || !compress::read_block(block, source.current(), file->buffer + written))
+                break;
+
+            source.skip(block.size);
+            written += block.raw;
+        }
+
+        if (written == filesize && !source.remaining())
+            return file;
+
+        delete file;
+        return nullptr;
+    }
+
+    void DiskCache::store(const char* address, const char* filename, const char* buffer, c_uint filesize, c_uint chunks)
+    {
+        std::string location;
+        bool        packed;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (directory.empty() || sizeof(header) + filesize + 1 > budget) return;
+            location = path(address, filename);
+            packed   = compress;
+        }
+
+        // Unique per writer, so concurrent stores of the same file don't share a temporary
+        const unsigned long long id = std::hash<std::thread::id>()(std::this_thread::get_id()) ^ (unsigned long long)now();
+        const std::string temporary = location + "." + std::to_string(id) + ".tmp";
+
+        header h;
+        std::memcpy(h.magic, cache_magic, sizeof(cache_magic));
+        h.filesize = endian::little(filesize);
+        h.chunks   = endian::little(chunks);
+        h.flags    = endian::little(packed ? COMPRESSED : 0u);
+
+        unsigned long long stored = sizeof(header);
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            out.write((const char*)&h, sizeof(header));
+
+            if (packed)
+            {
+                std::vector<char> block(_FIN_BLOCK_BOUND(_FIN_CACHE_BLOCK));
+                for (unsigned int i = 0; i < filesize; i += _FIN_CACHE_BLOCK)
+                {
+                    const unsigned int length = compress::write_block(buffer + i, std::min<unsigned int>(_FIN_CACHE_BLOCK, filesize - i), block.data());
+                    out.write(block.data(), length);
+                    stored += length;
+                }
+            }
+            else
+            {
+                // The terminator is stored as well, so a mapped entry ends in one like a download does
+                out.write(buffer, filesize);
+                out.put('\0');
+                stored += filesize + 1;
+            }
+
+            out.close();
+
+            std::error_code error;
+            if (!out) { fs::remove(temporary, error); return; }
+        }
+
+        std::error_code error;
+        fs::rename(temporary, location, error);
+        if (error) { fs::remove(temporary, error); return; }
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        entry& e = entries[location];
+        total -= e.size;
+
+        e.size      = stored;
+        e.last_used = now();
+        total += e.size;
+
+        evict();
+    }
+
+    void DiskCache::evict()
+    {
+        if (total <= budget) return;
+
+        std::vector<std::pair<long long, std::string>> order;
+        order.reserve(entries.size());
+
+        for (auto& e : entries)
+            order.emplace_back(e.second.last_used, e.first);
+
+        std::sort(order.begin(), order.end());
+
+        std::error_code error;
+        for (auto& e : order)
+        {
+            if (total <= budget) break;
+
+            fs::remove(e.second, error);
+
+            total -= entries[e.second].size;
+            entries.erase(e.second);
+        }
+    }
+
+    void DiskCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::error_code error;
+        for (auto& e : entries)
+            fs::remove(e.first, error);
+
+        entries.clear();
+        total = 0;
+    }
+
+    unsigned long long DiskCache::size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return total;
+    }
+
+    DiskCache& cache()
+    {
+        static DiskCache instance;
+        return instance;
+    }
+}
+}
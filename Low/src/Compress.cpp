@@ -0,0 +1,188 @@
+#include "finapi/finapi.h"
+
+// Bits of the match finder's hash table
+#define _FIN_LZ_HASH_BITS 13
+
+// Shortest match worth a sequence
+#define _FIN_LZ_MIN_MATCH 4
+
+namespace finapi
+{
+namespace compress
+{
+    static inline unsigned int read32(const char* p)
+    {
+        unsigned int r;
+        std::memcpy(&r, p, sizeof(r));
+        return r;
+    }
+
+    static inline unsigned int hash(const unsigned int v)
+    {
+        return (v * 2654435761u) >> (32 - _FIN_LZ_HASH_BITS);
+    }
+
+    /**
+     * @brief Writes the remainder of a length that didn't fit its nibble.
+     */
+    static inline bool write_length(unsigned int length, char*& op, const char* end)
+    {
+        for (; length >= 255; length -= 255)
+        {
+            if (op >= end) return false;
+            *op++ = (char)255;
+        }
+
+        if (op >= end) return false;
+        *op++ = (char)length;
+        return true;
+    }
+
+    static inline bool read_length(unsigned int& length, const char*& ip, const char* end)
+    {
+        unsigned char b;
+        do
+        {
+            if (ip >= end) return false;
+            b = *ip++;
+            length += b;
+        } while (b == 255);
+
+        return true;
+    }
+
+    /**
+     * @brief Emits the literals since the anchor followed by a match, or just the literals.
+     */
+    static bool sequence(const char* literals, c_uint count, c_uint offset, c_uint match, char*& op, const char* end)
+    {
+        const unsigned int extra = (match ? match - _FIN_LZ_MIN_MATCH : 0);
+
+        if (op >= end) return false;
+        char* token = op++;
+        *token = (char)((std::min(count, 15u) << 4) | std::min(extra, 15u));
+
+        if (count >= 15 && !write_length(count - 15, op, end)) return false;
+
+        if ((unsigned int)(end - op) < count) return false;
+        std::memcpy(op, literals, count);
+        op += count;
+
+        if (!match) return true;
+
+        if (end - op < 2) return false;
+        *op++ = (char)(offset & 0xFF);
+        *op++ = (char)(offset >> 8);
+
+        return (extra < 15 || write_length(extra - 15, op, end));
+    }
+
+    unsigned int encode(const char* src, c_uint size, char* dest, c_uint capacity)
+    {
+        unsigned int table[1 << _FIN_LZ_HASH_BITS];
+        std::memset(table, 0, sizeof(table));
+
+        char*       op  = dest;
+        const char* end = dest + capacity;
+
+        unsigned int ip = 0, anchor = 0;
+        while (ip + _FIN_LZ_MIN_MATCH <= size)
+        {
+            const unsigned int v = read32(src + ip);
+            const unsigned int h = hash(v);
+            const unsigned int candidate = table[h];
+            table[h] = ip;
+
+            if (candidate >= ip || ip - candidate > 0xFFFF || read32(src + candidate) != v)
+            {
+                // Step faster through stretches that don't compress
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            unsigned int length = _FIN_LZ_MIN_MATCH;
+            while (ip + length < size && src[candidate + length] == src[ip + length])
+                length++;
+
+            if (!sequence(src + anchor, ip - anchor, ip - candidate, length, op, end))
+                return 0;
+
+            ip    += length;
+            anchor = ip;
+        }
+
+        if (!sequence(src + anchor, size - anchor, 0, 0, op, end))
+            return 0;
+
+        return op - dest;
+    }
+
+    bool decode(const char* src, c_uint size, char* dest, c_uint raw)
+    {
+        const char* ip  = src;
+        const char* end = src + size;
+        char*       op  = dest;
+        char*       out = dest + raw;
+
+        while (ip < end)
+        {
+            const unsigned char token = *ip++;
+
+            unsigned int count = token >> 4;
+            if (count == 15 && !read_length(count, ip, end)) return false;
+
+            if ((unsigned int)(end - ip) < count || (unsigned int)(out - op) < count) return false;
+            std::memcpy(op, ip, count);
+            ip += count;
+            op += count;
+
+            // Only the last sequence ends right after its literals
+            if (ip == end) break;
+
+            if (end - ip < 2) return false;
+            const unsigned int offset = (unsigned char)ip[0] | ((unsigned char)ip[1] << 8);
+            ip += 2;
+
+            unsigned int length = token & 15;
+            if (length == 15 && !read_length(length, ip, end)) return false;
+            length += _FIN_LZ_MIN_MATCH;
+
+            if (!offset || offset > (unsigned int)(op - dest) || (unsigned int)(out - op) < length)
+                return false;
+
+            // Matches may overlap the bytes they produce, so copy forwards one at a time
+            const char* match = op - offset;
+            for (unsigned int i = 0; i < length; i++)
+                op[i] = match[i];
+            op += length;
+        }
+
+        return op == out;
+    }
+
+    unsigned int write_block(const char* src, c_uint raw, char* dest)
+    {
+        block_header header = { 0, raw };
+
+        // Anything that doesn't come out smaller is stored as it is
+        header.size = encode(src, raw, dest + sizeof(header), raw ? raw - 1 : 0);
+        if (!header.size)
+        {
+            header.size = raw;
+            std::memcpy(dest + sizeof(header), src, raw);
+        }
+
+        const block_header stored = { endian::little(header.size), endian::little(header.raw) };
+        std::memcpy(dest, &stored, sizeof(stored));
+        return sizeof(header) + header.size;
+    }
+
+    bool read_block(const block_header& header, const char* payload, char* dest)
+    {
+        if (header.size == header.raw)
+            { std::memcpy(dest, payload, header.raw); return true; }
+
+        return (header.size < header.raw && decode(payload, header.size, dest, header.raw));
+    }
+}
+}
@@ -0,0 +1,195 @@
+#include "finapi/finapi.h"
+
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#   include <emmintrin.h>
+#   define _FIN_SSE2
+#endif
+
+namespace finapi
+{
+    /*          Dictionary          */
+    unsigned int Dictionary::encode(std::string_view str)
+    {
+        auto it = codes.find(str);
+        if (it != codes.end()) return it->second;
+
+        const unsigned int code = strings.size();
+        strings.emplace_back(str);
+        codes.emplace(std::string_view(strings.back()), code);
+        return code;
+    }
+
+    unsigned int Dictionary::find(std::string_view str) const
+    {
+        auto it = codes.find(str);
+        return (it == codes.end() ? npos : it->second);
+    }
+
+    void Dictionary::clear()
+    {
+        codes.clear();
+        strings.clear();
+    }
+
+    /*         DataTagTable         */
+    void DataTagTable::clear()
+    {
+        value.clear();
+        sequence.clear();
+
+        for (int c = 0; c < COLUMNS; c++)
+        {
+            codes[c].clear();
+            dictionaries[c].clear();
+        }
+    }
+
+    unsigned int DataTagTable::count(const column c, c_uint code) const
+    {
+        const unsigned int* keys = codes[c].data();
+        const unsigned int  n    = size();
+        unsigned int i = 0, r = 0;
+
+    #ifdef _FIN_SSE2
+        const __m128i key = _mm_set1_epi32(code);
+        __m128i acc = _mm_setzero_si128();
+
+        // A matching lane compares to -1, so subtracting the mask counts it
+        for (; i + 4 <= n; i += 4)
+            acc = _mm_sub_epi32(acc, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(keys + i)), key));
+
+        unsigned int lanes[4];
+        _mm_storeu_si128((__m128i*)lanes, acc);
+        r = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    #endif
+
+        for (; i < n; i++)
+            r += (keys[i] == code);
+
+        return r;
+    }
+
+    double DataTagTable::sum(const column c, c_uint code) const
+    {
+        const unsigned int* keys   = codes[c].data();
+        const float*        values = value.data();
+        const unsigned int  n      = size();
+        unsigned int i = 0;
+        double r = 0;
+
+    #ifdef _FIN_SSE2
+        const __m128i key = _mm_set1_epi32(code);
+        __m128d low  = _mm_setzero_pd();
+        __m128d high = _mm_setzero_pd();
+
+        // Zero out the values of rows that don't match, then widen to double so long
+        // columns don't lose precision
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m128  mask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(keys + i)), key));
+            const __m128  v    = _mm_and_ps(mask, _mm_loadu_ps(values + i));
+
+            low  = _mm_add_pd(low,  _mm_cvtps_pd(v));
+            high = _mm_add_pd(high, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+        }
+
+        double lanes[2];
+        _mm_storeu_pd(lanes, _mm_add_pd(low, high));
+        r = lanes[0] + lanes[1];
+    #endif
+
+        for (; i < n; i++)
+            if (keys[i] == code) r += values[i];
+
+        return r;
+    }
+
+    float DataTagTable::min(const column c, c_uint code) const
+    {
+        const unsigned int* keys   = codes[c].data();
+        const float*        values = value.data();
+        const unsigned int  n      = size();
+        unsigned int i = 0;
+        float r = std::numeric_limits<float>::infinity();
+
+    #ifdef _FIN_SSE2
+        const __m128i key  = _mm_set1_epi32(code);
+        const __m128  fill = _mm_set1_ps(r);
+        __m128 acc = fill;
+
+        // Rows that don't match are replaced with +infinity before the lane-wise min
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m128 mask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(keys + i)), key));
+            const __m128 v    = _mm_or_ps(_mm_and_ps(mask, _mm_loadu_ps(values + i)), _mm_andnot_ps(mask, fill));
+            acc = _mm_min_ps(acc, v);
+        }
+
+        float lanes[4];
+        _mm_storeu_ps(lanes, acc);
+        r = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+    #endif
+
+        for (; i < n; i++)
+            if (keys[i] == code) r = std::min(r, values[i]);
+
+        return r;
+    }
+
+    float DataTagTable::max(const column c, c_uint code) const
+    {
+        const unsigned int* keys   = codes[c].data();
+        const float*        values = value.data();
+        const unsigned int  n      = size();
+        unsigned int i = 0;
+        float r = -std::numeric_limits<float>::infinity();
+
+    #ifdef _FIN_SSE2
+        const __m128i key  = _mm_set1_epi32(code);
+        const __m128  fill = _mm_set1_ps(r);
+        __m128 acc = fill;
+
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m128 mask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(keys + i)), key));
+            const __m128 v    = _mm_or_ps(_mm_and_ps(mask, _mm_loadu_ps(values + i)), _mm_andnot_ps(mask, fill));
+            acc = _mm_max_ps(acc, v);
+        }
+
+        float lanes[4];
+        _mm_storeu_ps(lanes, acc);
+        r = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    #endif
+
+        for (; i < n; i++)
+            if (keys[i] == code) r = std::max(r, values[i]);
+
+        return r;
+    }
+
+    void DataTagTable::filter(const column c, c_uint code, std::vector<unsigned int>& rows) const
+    {
+        const unsigned int* keys = codes[c].data();
+        const unsigned int  n    = size();
+        unsigned int i = 0;
+
+        rows.clear();
+
+    #ifdef _FIN_SSE2
+        const __m128i key = _mm_set1_epi32(code);
+
+        // Test four rows at a time and only look at the individual lanes when one matched
+        for (; i + 4 <= n; i += 4)
+        {
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(keys + i)), key)));
+            for (unsigned int lane = i; mask; mask >>= 1, lane++)
+                if (mask & 1) rows.push_back(lane);
+        }
+    #endif
+
+        for (; i < n; i++)
+            if (keys[i] == code) rows.push_back(i);
+    }
+}
@@ -0,0 +1,74 @@
+#include "finapi/finapi.h"
+
+namespace finapi
+{
+namespace format
+{
+    bool upgrade_tags(const char* data, c_uint size, std::vector<char>& out, const bool tag_index)
+    {
+        const DataTagListView tags(data, size);
+        if (!tags.valid()) return false;
+
+        const unsigned int count = tags.size();
+
+        // The records are copied over as one block, so every one of them has to be in the
+        // buffer and start where the one before it ends
+        const char* begin = (count ? tags[0].data() : nullptr);
+        const char* end   = begin;
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            if (!end || tags[i].data() != end) return false;
+            end = DataTagView::skip(end, data + size);
+        }
+
+        if (count && !end) return false;
+
+        const unsigned int records = sizeof(tag_header) + count * sizeof(unsigned int);
+        const unsigned int length  = end - begin;
+
+        tag_header header;
+        header.magic = VERSIONED_MN(DATA_TAG_MN, FORMAT_VERSION);
+        header.count = count;
+        header.flags = (tag_index ? TAG_INDEX : 0);
+        header.index = (tag_index ? records + length : 0);
+
+        out.resize(records + length + (tag_index ? count * sizeof(unsigned int) : 0));
+        char* cursor = out.data();
+
+        // The header and tables are stored little endian like every other number
+        header.magic = endian::little(header.magic);
+        header.count = endian::little(header.count);
+        header.flags = endian::little(header.flags);
+        header.index = endian::little(header.index);
+
+        std::memcpy(cursor, &header, sizeof(header));
+        cursor += sizeof(header);
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            const unsigned int offset = endian::little<unsigned int>(records + (tags[i].data() - begin));
+            std::memcpy(cursor, &offset, sizeof(offset));
+            cursor += sizeof(offset);
+        }
+
+        if (length) std::memcpy(cursor, begin, length);
+        cursor += length;
+
+        if (!tag_index) return true;
+
+        // Record numbers ordered by tag, records sharing a tag stay in file order
+        std::vector<std::string_view> names(count);
+        for (unsigned int i = 0; i < count; i++)
+            names[i] = tags[i].tag();
+
+        std::vector<unsigned int> order(count);
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&names](c_uint a, c_uint b) { return names[a] < names[b]; });
+
+        endian::little(order.data(), count);
+        if (count) std::memcpy(cursor, order.data(), count * sizeof(unsigned int));
+        return true;
+    }
+}
+}
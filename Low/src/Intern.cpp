@@ -0,0 +1,84 @@
+#include "finapi/finapi.h"
+
+// Slots in each thread's cache of recently interned strings, must be a power of two
+#define _FIN_INTERN_CACHE 512
+
+namespace finapi
+{
+    /**
+     * @brief Per-thread direct mapped cache in front of the shards.
+     *
+     * Interned strings are immutable and never freed, so a thread can keep pointers to them
+     * around and answer repeated lookups without touching a lock.
+     */
+    struct intern_cache
+    {
+        const InternTable* table;
+        std::size_t        hash;
+        const char*        str;
+        unsigned int       length;
+    };
+
+    static thread_local intern_cache cache[_FIN_INTERN_CACHE];
+
+    InternTable::InternTable() :
+        on(true), lookups(0), hits(0), strings(0), bytes_stored(0), bytes_saved(0)
+    {   }
+
+    const char* InternTable::intern(const char* str, c_uint length)
+    {
+        const std::string_view key(str, length);
+        const std::size_t      hash = std::hash<std::string_view>()(key);
+        intern_cache& slot = cache[hash & (_FIN_INTERN_CACHE - 1)];
+
+        lookups.fetch_add(1, std::memory_order_relaxed);
+
+        if (slot.table == this && slot.hash == hash && slot.length == length && !std::memcmp(slot.str, str, length))
+        {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            bytes_saved.fetch_add(length + 1, std::memory_order_relaxed);
+            return slot.str;
+        }
+
+        shard& s = shards[hash % _FIN_INTERN_SHARDS];
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        auto it = s.strings.find(key);
+        if (it != s.strings.end())
+        {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            bytes_saved.fetch_add(length + 1, std::memory_order_relaxed);
+
+            slot = { this, hash, it->second, length };
+            return it->second;
+        }
+
+        char* copy = s.storage.allocate_string(length);
+        std::memcpy(copy, str, length);
+        copy[length] = '\0';
+
+        s.strings.emplace(std::string_view(copy, length), copy);
+        slot = { this, hash, copy, length };
+
+        strings.fetch_add(1, std::memory_order_relaxed);
+        bytes_stored.fetch_add(length + 1, std::memory_order_relaxed);
+        return copy;
+    }
+
+    InternTable::stats InternTable::statistics() const
+    {
+        stats r;
+        r.lookups      = lookups.load(std::memory_order_relaxed);
+        r.hits         = hits.load(std::memory_order_relaxed);
+        r.strings      = strings.load(std::memory_order_relaxed);
+        r.bytes_stored = bytes_stored.load(std::memory_order_relaxed);
+        r.bytes_saved  = bytes_saved.load(std::memory_order_relaxed);
+        return r;
+    }
+
+    InternTable& interned()
+    {
+        static InternTable instance;
+        return instance;
+    }
+}
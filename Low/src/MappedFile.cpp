@@ -0,0 +1,63 @@
+#include "finapi/finapi.h"
+
+#ifndef _FIN_WINDOWS
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#endif
+
+namespace finapi
+{
+    MappedFile::MappedFile(const char* path) :
+        ptr(nullptr), length(0), mapped(false)
+    {
+    #ifndef _FIN_WINDOWS
+        const int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+
+        struct stat info;
+        // Sizes are unsigned int throughout, a bigger file would be cut off without notice
+        if (fstat(fd, &info) == 0 && info.st_size > 0 && (unsigned long long)info.st_size <= UINT_MAX)
+        {
+            void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED)
+            {
+                // The deserializers walk the file front to back
+                madvise(map, info.st_size, MADV_SEQUENTIAL);
+
+                ptr    = (const char*)map;
+                length = info.st_size;
+                mapped = true;
+            }
+        }
+
+        close(fd);
+    #else
+        // No mmap here, fall back to reading the whole file in one go
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) return;
+
+        const std::streamoff size = file.tellg();
+        if (size < 0 || (unsigned long long)size > UINT_MAX) return;
+
+        length = (unsigned int)size;
+        file.seekg(0);
+
+        char* buffer = CHAR_ALLOC(length);
+        file.read(buffer, length);
+        ptr = buffer;
+    #endif
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (!ptr) return;
+
+    #ifndef _FIN_WINDOWS
+        if (mapped)
+            { munmap((void*)ptr, length); return; }
+    #endif
+
+        std::free((void*)ptr);
+    }
+}
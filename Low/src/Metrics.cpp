@@ -0,0 +1,141 @@
+#include "finapi/finapi.h"
+
+#include <cmath>
+#include <cstdio>
+
+namespace finapi
+{
+namespace metrics
+{
+    // Zero-initialized as a static, the pages of shards nobody records into are never touched
+    static shard shards[_FIN_METRIC_SHARDS];
+
+    shard& assign_shard()
+    {
+        static std::atomic<unsigned int> next(0);
+        return shards[next.fetch_add(1, std::memory_order_relaxed) % _FIN_METRIC_SHARDS];
+    }
+
+    double distribution::percentile(const double p) const
+    {
+        if (!count) return 0.0;
+
+        const unsigned long long rank = std::max<unsigned long long>(1, std::ceil(p * count));
+
+        unsigned long long seen = 0;
+        for (unsigned int i = 0; i < buckets.size(); i++)
+        {
+            seen += buckets[i];
+            if (seen < rank) continue;
+
+            if (i < SUB_BUCKETS) return bucket_floor(i);
+            return (bucket_floor(i) + (i + 1 < BUCKETS ? bucket_floor(i + 1) : bucket_floor(i) * 2)) / 2.0;
+        }
+
+        return bucket_floor(BUCKETS - 1);
+    }
+
+    snapshot collect()
+    {
+        snapshot r;
+
+        for (unsigned int c = 0; c < COUNTERS; c++)
+        {
+            r.counters[c] = 0;
+            for (const shard& s : shards)
+                r.counters[c] += s.counters[c].load(std::memory_order_relaxed);
+        }
+
+        for (unsigned int h = 0; h < HISTOGRAMS; h++)
+        {
+            distribution& dist = r.histograms[h];
+            dist.count = 0;
+            dist.sum   = 0;
+            dist.buckets.assign(BUCKETS, 0);
+
+            for (const shard& s : shards)
+            {
+                dist.sum += s.histograms[h].sum.load(std::memory_order_relaxed);
+                for (unsigned int i = 0; i < BUCKETS; i++)
+                    dist.buckets[i] += s.histograms[h].buckets[i].load(std::memory_order_relaxed);
+            }
+
+            for (const unsigned long long n : dist.buckets)
+                dist.count += n;
+        }
+
+        return r;
+    }
+
+    void reset()
+    {
+        for (shard& s : shards)
+        {
+            for (auto& c : s.counters)
+                c.store(0, std::memory_order_relaxed);
+
+            for (auto& h : s.histograms)
+            {
+                h.sum.store(0, std::memory_order_relaxed);
+                for (auto& b : h.buckets)
+                    b.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    const char* name(const counter c)
+    {
+        static const char* names[COUNTERS] = {
+            "connects", "connect_failures", "login_failures", "commands", "chunks",
+            "chunk_failures", "chunk_retries", "bytes_sent", "bytes_received"
+        };
+
+        return (c < COUNTERS ? names[c] : "");
+    }
+
+    const char* name(const histogram h)
+    {
+        static const char* names[HISTOGRAMS] = {
+            "connect", "login", "exists", "size", "chunk_count", "command", "chunk", "file", "deserialize"
+        };
+
+        return (h < HISTOGRAMS ? names[h] : "");
+    }
+
+    std::string expose(const snapshot& s)
+    {
+        static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+        std::string r;
+        char line[160];
+
+        for (unsigned int c = 0; c < COUNTERS; c++)
+        {
+            std::snprintf(line, sizeof(line), "# TYPE finapi_%s_total counter\nfinapi_%s_total %llu\n",
+                          name((counter)c), name((counter)c), s.counters[c]);
+            r += line;
+        }
+
+        for (unsigned int h = 0; h < HISTOGRAMS; h++)
+        {
+            const char*         metric = name((histogram)h);
+            const distribution& dist   = s.histograms[h];
+
+            std::snprintf(line, sizeof(line), "# TYPE finapi_%s_seconds summary\n", metric);
+            r += line;
+
+            for (const double q : quantiles)
+            {
+                std::snprintf(line, sizeof(line), "finapi_%s_seconds{quantile=\"%g\"} %.9f\n", metric, q, dist.percentile(q) / 1e9);
+                r += line;
+            }
+
+            std::snprintf(line, sizeof(line), "finapi_%s_seconds_sum %.9f\nfinapi_%s_seconds_count %llu\n",
+                          metric, dist.sum / 1e9, metric, dist.count);
+            r += line;
+        }
+
+        return r;
+    }
+}
+}
@@ -0,0 +1,226 @@
+#include "finapi/finapi.h"
+
+namespace finapi
+{
+    /**
+     * @brief Bytes held by the string fields of a model that aren't interned.
+     */
+    template<typename T>
+    static unsigned long long string_bytes(const T& model)
+    {
+        unsigned long long r = 0;
+        schema::visit<T>([&](auto field)
+        {
+            typedef decltype(field) F;
+            if constexpr (F::string)
+            {
+                const char* string = model.*F::member;
+                if (string && !(model.interned & (1u << F::index)))
+                    r += std::strlen(string) + 1;
+            }
+        });
+
+        return r;
+    }
+
+    template<>
+    unsigned long long ModelCache<Company>::footprint(const Company& model)
+    {
+        return sizeof(Company) + string_bytes(model);
+    }
+
+    template<>
+    unsigned long long ModelCache<Statement>::footprint(const Statement& model)
+    {
+        return sizeof(Statement) + string_bytes(model);
+    }
+
+    template<>
+    unsigned long long ModelCache<std::vector<DataTag*>>::footprint(const std::vector<DataTag*>& model)
+    {
+        unsigned long long r = sizeof(model) + model.capacity() * sizeof(DataTag*);
+        for (const DataTag* tag : model)
+            r += sizeof(DataTag) + string_bytes(*tag);
+
+        return r;
+    }
+
+    /**
+     * @brief Parses a downloaded file into a model owned by a shared pointer.
+     */
+    template<typename T>
+    static std::shared_ptr<const T> parse(ByteSource& source)
+    {
+        T* model = nullptr;
+        deserialize(&model, source);
+        return std::shared_ptr<const T>(model);
+    }
+
+    template<>
+    std::shared_ptr<const std::vector<DataTag*>> parse<std::vector<DataTag*>>(ByteSource& source)
+    {
+        std::vector<DataTag*>* tags = new std::vector<DataTag*>();
+        deserialize(*tags, source);
+
+        return std::shared_ptr<const std::vector<DataTag*>>(tags, [](const std::vector<DataTag*>* list)
+        {
+            clean_list(*const_cast<std::vector<DataTag*>*>(list));
+            delete list;
+        });
+    }
+
+    template<typename T>
+    ModelCache<T>::ModelCache(const unsigned long long budget) :
+        budget(budget), bytes(0), hits(0), misses(0), coalesced(0), evictions(0)
+    {   }
+
+    template<typename T>
+    typename ModelCache<T>::result ModelCache<T>::load(const char* filename, const char* address)
+    {
+        Cloud::File* file;
+        Cloud::get_file(filename, address, file);
+
+        result r = { nullptr, file->status };
+        if (file->status == Cloud::OK)
+        {
+            ByteSource source = file->source();
+            r.model = parse<T>(source);
+
+            // A file that is cut off isn't cached as if it were whole
+            if (source.truncated)
+                r = { nullptr, Cloud::PARTIAL };
+        }
+
+        delete file;
+        return r;
+    }
+
+    template<typename T>
+    std::shared_ptr<const T> ModelCache<T>::get(const char* filename, const char* address, Cloud::Status* status)
+    {
+        const std::string key(filename);
+
+        std::unique_lock<std::mutex> lock(mutex);
+
+        auto it = entries.find(key);
+        if (it != entries.end())
+        {
+            hits++;
+            order.splice(order.begin(), order, it->second.use);
+
+            if (status) *status = Cloud::OK;
+            return it->second.model;
+        }
+
+        misses++;
+
+        // Somebody is already pulling this file, wait for their result
+        auto pending = loading.find(key);
+        if (pending != loading.end())
+        {
+            coalesced++;
+            std::shared_future<result> future = pending->second;
+            lock.unlock();
+
+            const result& r = future.get();
+            if (status) *status = r.status;
+            return r.model;
+        }
+
+        // However this call is left, load() throwing included, the key stops loading and
+        // the callers waiting on it are handed a result, an EMPTY one if there is none
+        struct completion
+        {
+            ModelCache&                   cache;
+            const std::string&            key;
+            std::unique_lock<std::mutex>& lock;
+            std::promise<result>          promise;
+            result                        r;
+
+            ~completion()
+            {
+                if (!lock.owns_lock()) lock.lock();
+                cache.loading.erase(key);
+                lock.unlock();
+
+                promise.set_value(r);
+            }
+        } done = { *this, key, lock, {}, { nullptr, Cloud::EMPTY } };
+
+        loading.emplace(key, done.promise.get_future().share());
+        lock.unlock();
+
+        done.r = load(filename, address);
+        const unsigned long long size = (done.r.model ? footprint(*done.r.model) : 0);
+
+        lock.lock();
+
+        if (done.r.model && size <= budget)
+        {
+            order.push_front(key);
+            entries[key] = { done.r.model, size, order.begin() };
+            bytes += size;
+            evict();
+        }
+
+        if (status) *status = done.r.status;
+        return done.r.model;
+    }
+
+    template<typename T>
+    void ModelCache<T>::evict()
+    {
+        while (bytes > budget && !order.empty())
+        {
+            auto it = entries.find(order.back());
+            bytes -= it->second.bytes;
+            entries.erase(it);
+            order.pop_back();
+
+            evictions++;
+        }
+    }
+
+    template<typename T>
+    void ModelCache<T>::erase(const char* filename)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto it = entries.find(filename);
+        if (it == entries.end()) return;
+
+        bytes -= it->second.bytes;
+        order.erase(it->second.use);
+        entries.erase(it);
+    }
+
+    template<typename T>
+    void ModelCache<T>::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        entries.clear();
+        order.clear();
+        bytes = 0;
+    }
+
+    template<typename T>
+    void ModelCache<T>::set_budget(const unsigned long long limit)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        budget = limit;
+        evict();
+    }
+
+    template<typename T>
+    typename ModelCache<T>::stats ModelCache<T>::statistics()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return { hits, misses, coalesced, evictions, (unsigned long)entries.size(), bytes };
+    }
+
+    template class ModelCache<Company>;
+    template class ModelCache<Statement>;
+    template class ModelCache<std::vector<DataTag*>>;
+}
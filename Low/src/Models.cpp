@@ -2,29 +2,190 @@
 
 #define TEMP_TYPES(type)\
     template void deserialize<std::ifstream>(type, std::ifstream&);\
-    template void deserialize<Cloud::File*>(type, Cloud::File*&);
+    template void deserialize<Cloud::File*>(type, Cloud::File*&);\
+    template void deserialize<ByteSource>(type, ByteSource&);\
+    template void deserialize<std::ifstream>(type, std::ifstream&, Arena&);\
+    template void deserialize<Cloud::File*>(type, Cloud::File*&, Arena&);\
+    template void deserialize<ByteSource>(type, ByteSource&, Arena&);
 
 namespace finapi
 {
+    /**
+     * @brief Allocation policy of the regular deserializers, every object and string
+     *        goes to the heap and is freed by its owner.
+     */
+    struct heap_alloc
+    {
+        char* allocate_string(c_uint length)
+            { return STRING_ALLOC(length); }
+
+        template<typename T>
+        T* create()
+            { return new T; }
+
+        template<typename T>
+        void discard(T* object)
+            { delete object; }
+    };
+
+    /**
+     * @brief An object the arena handed out stays with it, so it is only left behind.
+     */
+    template<typename T>
+    static void discard(Arena&, T*) {   }
+
+    template<typename T>
+    static void discard(heap_alloc& alloc, T* object)
+        { alloc.discard(object); }
+
+    /**
+     * @brief Cursor over a record that was checked to fit the buffer, it reads without checks.
+     */
+    struct record_cursor
+    {
+        const char* at;
+    };
+
     /*        BufferStruct.h         */ 
 namespace filemethods
 {
-    void read(std::ifstream& file, STRING_FIELD& string)
+    static void read_bytes(std::ifstream& file, char* dest, c_uint size)
+        { file.read(dest, size); }
+
+    static void read_bytes(Cloud::File* file, char* dest, c_uint size)
+        { file->read(dest, size); }
+
+    static void read_bytes(ByteSource& file, char* dest, c_uint size)
+        { file.read(dest, size); }
+
+    static void skip(std::ifstream& file, c_uint size)
+        { file.seekg(size, std::ios::cur); }
+
+    static void skip(Cloud::File* file, c_uint size)
+        { file->skip(size); }
+
+    static void skip(ByteSource& file, c_uint size)
+        { file.skip(size); }
+
+    static void read_bytes(record_cursor& file, char* dest, c_uint size)
+        { std::memcpy(dest, file.at, size); file.at += size; }
+
+    template<typename T>
+    static T read(record_cursor& file)
     {
-        const unsigned int size = read<unsigned int>(file);
-        string = STRING_ALLOC(size);
+        const T r = endian::load<T>(file.at);
+        file.at += sizeof(T);
+        return r;
+    }
+
+    template<typename T>
+    static void read(record_cursor& file, T* dest)
+        { *dest = read<T>(file); }
+
+    // Longest length prefix a stream is trusted with without measuring what is left of it
+    static constexpr unsigned int TRUSTED_LENGTH = 64 * 1024;
+
+    /**
+     * @brief Whether a length prefix fits the rest of the source, checked before anything
+     *        is allocated for it. A source it doesn't fit is left cut off.
+     */
+    static bool fits_length(std::ifstream& file, c_uint size)
+    {
+        // Measuring costs two seeks, a shorter prefix that lies only comes up short on the read
+        if (size <= TRUSTED_LENGTH) return true;
+
+        std::streambuf* buffer = file.rdbuf();
+        const std::streampos here = buffer->pubseekoff(0, std::ios::cur, std::ios::in);
+        const std::streampos end  = buffer->pubseekoff(0, std::ios::end, std::ios::in);
+        buffer->pubseekpos(here, std::ios::in);
+
+        if (here != std::streampos(-1) && end != std::streampos(-1) && end - here >= (std::streamoff)size)
+            return true;
+
+        file.setstate(std::ios::failbit);
+        return false;
+    }
+
+    static bool fits_length(Cloud::File* file, c_uint size)
+    {
+        if (size <= file->remaining()) return true;
+
+        file->skip(size);
+        return false;
+    }
+
+    static bool fits_length(ByteSource& file, c_uint size)
+    {
+        if (file.fits(size)) return true;
+
+        file.position = file.size;
+        return false;
+    }
+
+    // The record was checked to fit whole before the cursor was made
+    static bool fits_length(record_cursor&, c_uint)
+        { return true; }
+
+    /**
+     * @brief Reads a length prefixed string, allocating it with the given policy.
+     * 
+     * A length past the end of the source leaves the field empty and the source cut off.
+     */
+    template<typename T, typename A>
+    static void read_string(T& file, STRING_FIELD& string, A& alloc)
+    {
+        unsigned int size = read<unsigned int>(file);
+        if (!fits_length(file, size)) size = 0;
+
+        string = alloc.allocate_string(size);
         GET_CHAR(string, size) = '\0';
 
-        file.read(string, size);
+        read_bytes(file, string, size);
     }
 
-    void read(Cloud::File* file, STRING_FIELD& string)
+    /**
+     * @brief Reads a length prefixed string and points the field at its interned copy.
+     */
+    template<typename T>
+    static void read_interned(T& file, STRING_FIELD& string)
+    {
+        unsigned int size = read<unsigned int>(file);
+        if (!fits_length(file, size)) size = 0;
+
+        // Interned fields are short, so they normally fit on the stack
+        char local[256];
+        std::string spill;
+        char* scratch = local;
+        if (size > sizeof(local))
+            { spill.resize(size); scratch = &spill[0]; }
+
+        read_bytes(file, scratch, size);
+        string = (STRING_FIELD)interned().intern(scratch, size);
+    }
+
+    static void read_interned(record_cursor& file, STRING_FIELD& string)
     {
         const unsigned int size = read<unsigned int>(file);
-        string = STRING_ALLOC(size);
-        GET_CHAR(string, size) = '\0';
+        string = (STRING_FIELD)interned().intern(file.at, size);
+        file.at += size;
+    }
+
+    void read(std::ifstream& file, STRING_FIELD& string)
+    {
+        heap_alloc alloc;
+        read_string(file, string, alloc);
+    }
+
+    void read(Cloud::File* file, STRING_FIELD& string)
+    {
+        heap_alloc alloc;
+        read_string(file, string, alloc);
+    }
 
-        file->read(string, size);
+    void read(ByteSource& file, STRING_FIELD& string)
+    {
+        heap_alloc alloc;
+        read_string(file, string, alloc);
     }
 
     template<typename T>
@@ -35,107 +196,637 @@ namespace filemethods
 
     template unsigned int read_magic_number<std::ifstream>(std::ifstream&);
     template unsigned int read_magic_number<Cloud::File*>(Cloud::File*&);
+    template unsigned int read_magic_number<ByteSource>(ByteSource&);
 }
 
+    /*           Schema.h            */
+    /**
+     * @brief Reads the fields of a model at the current position, in the order of its schema.
+     * 
+     * The schema is expanded at compile time, so this comes down to one read per field
+     * without a loop or a check for the position of the non-string fields.
+     * 
+     * @param intern_mask Interned bits of the object, only fields the schema marks may be set
+     */
+    template<typename M, typename T, typename A>
+    static void read_fields(T& file, M* object, A& alloc, c_uint intern_mask = 0)
+    {
+        schema::visit<M>([&](auto field)
+        {
+            typedef decltype(field) F;
+            auto& member = object->*F::member;
+
+            if constexpr (!F::string)
+                filemethods::read(file, &member);
+            else
+            {
+                // Every DataTag string carries an extra length word in front of its own
+                if constexpr (F::type == schema::TAGGED_STRING)
+                    filemethods::read<unsigned int>(file);
+
+                if constexpr (F::intern)
+                {
+                    if (intern_mask & (1u << F::index))
+                        return filemethods::read_interned(file, member);
+                }
+
+                filemethods::read_string(file, member, alloc);
+            }
+        });
+
+        object->interned = intern_mask;
+    }
+
+    /**
+     * @brief Reads a record of a byte source that check_record() found to fit, without
+     *        checking every field again.
+     */
+    template<typename M, typename A>
+    static void read_fields(ByteSource& file, M* object, A& alloc, c_uint intern_mask = 0)
+    {
+        record_cursor cursor = { file.current() };
+        read_fields(cursor, object, alloc, intern_mask);
+        file.position = cursor.at - file.data;
+    }
+
+    /**
+     * @brief Checks whether the next record of a model can be read.
+     * 
+     * A byte source is checked against the lengths in the record once, so the fields can be
+     * read without any further checks. A stream checks each of its reads itself, here it
+     * only has to still be good.
+     */
+    template<typename M>
+    static bool check_record(ByteSource& file)
+    {
+        if (schema::extent<M>(file.current(), file.data + file.size)) return true;
+
+        file.truncated = true;
+        file.position  = file.size;
+        return false;
+    }
+
+    template<typename M>
+    static bool check_record(std::ifstream& file)
+        { return file.good(); }
+
+    template<typename M>
+    static bool check_record(Cloud::File* file)
+        { return file->status == Cloud::OK; }
+
+    /**
+     * @brief Whether the record that was just read came out whole.
+     */
+    static bool intact(ByteSource&)
+        { return true; }
+
+    static bool intact(std::ifstream& file)
+        { return !file.fail(); }
+
+    static bool intact(Cloud::File* file)
+        { return file->status == Cloud::OK; }
+
+    /**
+     * @brief Most records of a model the rest of the file can hold, to keep a bogus count
+     *        in a short file from reserving memory.
+     */
+    template<typename M>
+    static unsigned int most_records(ByteSource& file, c_uint count)
+        { return std::min(count, file.remaining() / schema::min_size<M>()); }
+
+    template<typename M>
+    static unsigned int most_records(Cloud::File* file, c_uint count)
+        { return std::min(count, file->filesize / schema::min_size<M>()); }
+
+    template<typename M>
+    static unsigned int most_records(std::ifstream&, c_uint count)
+        { return count; }
+
+    /**
+     * @brief Bytes the fields of a model take up in its file.
+     */
+    template<typename M>
+    static unsigned int fields_size(const M* object)
+    {
+        unsigned int r = 0;
+        schema::visit<M>([&](auto field)
+        {
+            typedef decltype(field) F;
+            const auto& member = object->*F::member;
+
+            if constexpr (!F::string)
+                r += sizeof(member);
+            else
+                r += (F::type == schema::TAGGED_STRING ? 2 : 1) * sizeof(unsigned int) + (member ? std::strlen(member) : 0);
+        });
+
+        return r;
+    }
+
+    /**
+     * @brief Writes the fields of a model in the order of its schema.
+     */
+    template<typename M>
+    static void write_fields(ByteSink& out, const M* object)
+    {
+        schema::visit<M>([&](auto field)
+        {
+            typedef decltype(field) F;
+            const auto& member = object->*F::member;
+
+            if constexpr (!F::string)
+                out.write(member);
+            else
+            {
+                // A missing string goes out as an empty one
+                const unsigned int size = (member ? std::strlen(member) : 0);
+
+                if constexpr (F::type == schema::TAGGED_STRING)
+                    out.write(size);
+
+                out.write(size);
+                if (size) out.write(member, size);
+            }
+        });
+    }
+
+    /**
+     * @brief Reads the magic number and field count in front of a single model.
+     */
+    template<typename M, typename T>
+    static void read_model_header(T& file)
+    {
+        const unsigned int magic = filemethods::read_magic_number(file);
+        const unsigned int count = filemethods::read<unsigned int>(file);
+
+        assert( MAGIC_NUMBER(magic) == schema::model<M>::magic );
+        assert( count == schema::model<M>::layout::count );
+        (void)magic; (void)count;
+    }
+
+    /**
+     * @brief Writes the magic number and field count in front of a single model.
+     */
+    template<typename M>
+    static void write_model_header(ByteSink& out)
+    {
+        out.write<unsigned int>(schema::model<M>::magic);
+        out.write<unsigned int>(schema::model<M>::layout::count);
+    }
+
     //   DataTag
+    /**
+     * @brief Reads the header of a DataTag file of any version, leaving the file at the first record.
+     * 
+     * @return unsigned int The record count
+     */
     template<typename T>
-    void deserialize(std::vector<DataTag*>& data, T& file)
+    static unsigned int read_tag_header(T& file)
     {
-        assert(file);
+		// Read the magic number, outside of the assert so it's still consumed in release builds
+		const unsigned int magic = filemethods::read_magic_number(file);
+		assert( MAGIC_NUMBER(magic) == schema::model<DataTag>::magic );
 
-		// Read the magic number
-		assert( filemethods::read_magic_number(file) == DATA_TAG_MN );
-		
         // Read in the object count
-        unsigned int count = filemethods::read<unsigned int>(file);
+        const unsigned int count = filemethods::read<unsigned int>(file);
+
+        // The records are read in order, so the rest of the v2 header and the offset table
+        // aren't needed
+        if (MAGIC_VERSION(magic) >= 2)
+            filemethods::skip(file, 2 * sizeof(unsigned int) + count * sizeof(unsigned int));
+
+        return count;
+    }
+
+    template<typename T, typename A>
+    static void deserialize_tags(std::vector<DataTag*>& data, T& file, A& alloc)
+    {
+        assert(file);
+        metrics::scope timed(metrics::DESERIALIZE_TIME);
+        trace::scope   traced("deserialize");
+
+        const unsigned int count = read_tag_header(file);
+
+        data.reserve(data.size() + most_records<DataTag>(file, count));
+
+        // Decide once per file whether the repetitive fields get shared copies
+        const unsigned int intern_mask = (interned().enabled() ? schema::intern_mask<DataTag>() : 0);
+
+        // A short file ends the list at its last whole record
+        for (unsigned int i = 0; i < count && check_record<DataTag>(file); i++)
+        {
+            DataTag* tag = alloc.template create<DataTag>();
+            read_fields(file, tag, alloc, intern_mask);
+
+            if (!intact(file)) { discard(alloc, tag); break; }
+            data.push_back(tag);
+        }
+    }
 
-        // Clean the list and reserve memory for the alloted amount of objects
+    template<typename T>
+    void deserialize(std::vector<DataTag*>& data, T& file)
+    {
+        // Clean the list before filling it back up
         clean_list(data);
-        data.reserve(count);
+        data.clear();
+
+        heap_alloc alloc;
+        deserialize_tags(data, file, alloc);
+    }
 
-        for (int i = 0; i < count; i++)
+    template<typename T>
+    void deserialize(std::vector<DataTag*>& data, T& file, Arena& arena)
+    {
+        // The objects in the list are owned by an arena, so there is nothing to free
+        data.clear();
+        deserialize_tags(data, file, arena);
+    }
+
+    /**
+     * @brief Moves a byte source holding a whole DataTag file to the start of a record.
+     * 
+     * The offset table of v2 files points straight at it, in v1 files the records in front
+     * of it are checked and skipped one by one.
+     */
+    static bool seek_tag(ByteSource& file, const DataTagListView& view, c_uint index)
+    {
+        file.position = 0;
+        read_tag_header(file);
+
+        if (view.offset_table())
+        {
+            const char* record = view[index].data();
+            if (!record) { file.truncated = true; return false; }
+
+            file.position = record - file.data;
+            return true;
+        }
+
+        for (unsigned int i = 0; i < index; i++)
+        {
+            const char* end = schema::extent<DataTag>(file.current(), file.data + file.size);
+            if (!end) { file.truncated = true; return false; }
+
+            file.position = end - file.data;
+        }
+
+        return true;
+    }
+
+    bool deserialize(std::vector<DataTag*>& data, ByteSource file, c_uint first, c_uint count)
+    {
+        metrics::scope timed(metrics::DESERIALIZE_TIME);
+        trace::scope   traced("deserialize");
+
+        const DataTagListView view(file.data, file.size);
+        if (!view.valid()) return false;
+        if (first >= view.size()) return true;
+
+        const unsigned int last = first + std::min(count, view.size() - first);
+        data.reserve(data.size() + std::min(last - first, most_records<DataTag>(file, last - first)));
+
+        const unsigned int intern_mask = (interned().enabled() ? schema::intern_mask<DataTag>() : 0);
+        heap_alloc alloc;
+
+        // Records are contiguous, so only the first one has to be looked up
+        if (!seek_tag(file, view, first)) return false;
+
+        for (unsigned int i = first; i < last && check_record<DataTag>(file); i++)
+        {
+            data.push_back(alloc.create<DataTag>());
+            read_fields(file, data.back(), alloc, intern_mask);
+        }
+
+        return !file.truncated;
+    }
+
+    bool deserialize(std::vector<DataTag*>& data, const ByteSource& file, ThreadPool& pool)
+    {
+        metrics::scope timed(metrics::DESERIALIZE_TIME);
+        trace::scope   traced("deserialize");
+
+        clean_list(data);
+        data.clear();
+
+        const DataTagListView view(file.data, file.size);
+        if (!view.valid()) return false;
+
+        // A count the file can't hold is cut down to what could be there before sizing the list
+        ByteSource scan(file.data, file.size);
+        read_tag_header(scan);
+
+        unsigned int count = most_records<DataTag>(scan, view.size());
+        bool whole = (count == view.size());
+
+        // Several ranges per thread so a slow one doesn't hold up the rest, but each large
+        // enough that handing it out costs next to nothing
+        const unsigned int ranges = std::max(1u, std::min((pool.size() + 1) * 4, count / _FIN_PARALLEL_MIN_RANGE));
+        const unsigned int length = std::max(1u, (count + ranges - 1) / ranges);
+
+        // Where each range starts. v2 files have an offset table, v1 files get a pre-scan
+        // that only hops over the length prefixes and ends at the last whole record
+        std::vector<unsigned int> starts;
+        starts.reserve(ranges);
+
+        if (view.offset_table())
+        {
+            // An offset outside of the file starts a range that comes up empty
+            for (unsigned int i = 0; i < count; i += length)
+            {
+                const char* record = view[i].data();
+                starts.push_back(record ? record - file.data : file.size);
+            }
+        }
+        else
         {
-            // Create a new DataTag object and store in list as well as collecting a few
-            // handles to the data
-            data.push_back(new DataTag);
-            DataTag*    scalar_tag = data.back();
-            STRING_LIST field_iter = (char**)scalar_tag;
-
-            // Field count specific to this data type
-            const unsigned int FIELD_COUNT = 7;
-            
-            for (int j = 0; j < FIELD_COUNT; j++)
+            for (unsigned int i = 0; i < count; i++)
             {
-                // At the fifth data point, read in an integer that is the sequence field
-                if (j == 5) filemethods::read(file, &scalar_tag->sequence);
+                const char* end = schema::extent<DataTag>(scan.current(), scan.data + scan.size);
+                if (!end) { count = i; whole = false; break; }
+
+                if (i % length == 0) starts.push_back(scan.position);
+                scan.position = end - scan.data;
+            }
+        }
+
+        data.resize(count);
+
+        const unsigned int intern_mask = (interned().enabled() ? schema::intern_mask<DataTag>() : 0);
 
-                // Read the size of the string, then pass the string to the object
-                unsigned int size = filemethods::read<unsigned int>(file);
+        // Records read by every range, a short one means the file was cut off inside it
+        std::vector<unsigned int> read(starts.size(), 0);
 
-                // Allocate a character buffer, and copy over
-                // data from file into the buffer
-                filemethods::read(file, GET_STRING(field_iter, j));
+        // Every range writes its own slots of the pre-sized list, so the order is the file's
+        auto decode = [&data, &file, &starts, &read, length, count, intern_mask](c_uint range)
+        {
+            heap_alloc alloc;
+            ByteSource source(file.data, file.size);
+            source.position = starts[range];
+
+            const unsigned int end = std::min(count, (range + 1) * length);
+            for (unsigned int i = range * length; i < end && check_record<DataTag>(source); i++)
+            {
+                data[i] = alloc.create<DataTag>();
+                read_fields(source, data[i], alloc, intern_mask);
+                read[range]++;
             }
+        };
+
+        TaskGroup group;
+        for (unsigned int range = 1; range < starts.size(); range++)
+            pool.submit([&decode, range]() { decode(range); }, &group);
+
+        // The calling thread takes the first range rather than sitting idle
+        if (!starts.empty()) decode(0);
+        group.wait();
+
+        // The list ends at the first record that couldn't be read, anything after it goes
+        for (unsigned int range = 0; range < starts.size(); range++)
+        {
+            const unsigned int begin = range * length;
+            if (read[range] == std::min(count, begin + length) - begin) continue;
+
+            for (unsigned int i = begin + read[range]; i < count; i++)
+                CLEAN_OBJ(data[i]);
+
+            data.resize(begin + read[range]);
+            return false;
+        }
+
+        return whole;
+    }
+
+    void serialize(const std::vector<DataTag*>& data, ByteSink& out, c_uint version)
+    {
+        const unsigned int count = data.size();
+
+        if (version < 2)
+        {
+            out.write<unsigned int>(DATA_TAG_MN);
+            out.write(count);
+
+            for (const DataTag* tag : data)
+                write_fields(out, tag);
+
+            return;
+        }
+
+        format::tag_header header;
+        header.magic = VERSIONED_MN(DATA_TAG_MN, 2);
+        header.count = count;
+        header.flags = format::TAG_INDEX;
 
-            // Finally, pull the value
-            filemethods::read(file, &scalar_tag->value);
+        // The offsets go in front of the records, so their sizes are summed up first
+        std::vector<unsigned int> offsets(count);
+        unsigned int offset = sizeof(header) + count * sizeof(unsigned int);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            offsets[i] = offset;
+            offset += fields_size(data[i]);
         }
+
+        header.index = offset;
+
+        out.write(header.magic);
+        out.write(header.count);
+        out.write(header.flags);
+        out.write(header.index);
+
+        endian::little(offsets.data(), count);
+        if (count) out.write(offsets.data(), count * sizeof(unsigned int));
+
+        for (const DataTag* tag : data)
+            write_fields(out, tag);
+
+        // Record numbers ordered by tag, records sharing a tag stay in list order
+        std::vector<unsigned int> order(count);
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&data](c_uint a, c_uint b)
+            { return std::strcmp(data[a]->tag ? data[a]->tag : "", data[b]->tag ? data[b]->tag : "") < 0; });
+
+        endian::little(order.data(), count);
+        if (count) out.write(order.data(), count * sizeof(unsigned int));
     }
 
     //   Company
-    template<typename T>
-    void deserialize(Company** data, T& file)
+    template<typename T, typename A>
+    static void deserialize_company(Company** data, T& file, A& alloc)
     {
         assert(file);
+        metrics::scope timed(metrics::DESERIALIZE_TIME);
+        trace::scope   traced("deserialize");
 
-        // Retreive the magic number
-        assert( filemethods::read_magic_number(file) == COMPANY_MN );
+        // Retreive the magic number and the count of fields, which should always be 5
+        read_model_header<Company>(file);
 
         // Create a pointer reference and allocate the memory for a company
-        // object as well as a string pointer
-        Company*& company    = *(data);
-        company              = new Company;
-        STRING_LIST str_iter = (char**)company;
+        // object, then pull its fields from the file. A cut off file leaves it empty
+        Company*& company = *(data);
+        company           = nullptr;
+        if (!check_record<Company>(file)) return;
 
-        // Get the count of fields (like with Statement, this should always
-        // be 5)
-        unsigned int count = filemethods::read<unsigned int>(file);
+        company = alloc.template create<Company>();
+        read_fields(file, company, alloc);
 
-        // Go through each field and allocate and pull the string from the file
-        // and into the object
-        for (int i = 0; i < count; i++)
-            filemethods::read(file, GET_STRING(str_iter, i));
+        if (!intact(file)) { discard(alloc, company); company = nullptr; }
     }
 
-    //  Statement
     template<typename T>
-    void deserialize(Statement** data, T& file)
+    void deserialize(Company** data, T& file)
+    {
+        heap_alloc alloc;
+        deserialize_company(data, file, alloc);
+    }
+
+    template<typename T>
+    void deserialize(Company** data, T& file, Arena& arena)
+    {
+        deserialize_company(data, file, arena);
+    }
+
+    void serialize(const Company* data, ByteSink& out)
+    {
+        write_model_header<Company>(out);
+        write_fields(out, data);
+    }
+
+    //  Statement
+    template<typename T, typename A>
+    static void deserialize_statement(Statement** data, T& file, A& alloc)
     {
         assert(file);
+        metrics::scope timed(metrics::DESERIALIZE_TIME);
+        trace::scope   traced("deserialize");
 
-        // Read the magic number
-        assert( filemethods::read_magic_number(file) == STATEMENT_MN );
+        // Read the magic number and the count of fields (though this should always be
+        // the same so long as the Statement type is being populated)
+        read_model_header<Statement>(file);
 
         // Create a reference pointer to the Statement in which we are manipulating
-        // as well as a string list pointer to the fields of the statement.
+        // and pull its fields from the file
         Statement*& statement = *(data);
-        statement = new Statement;
-        STRING_LIST str_iter = (char**)statement;
+        statement = nullptr;
+        if (!check_record<Statement>(file)) return;
+
+        statement = alloc.template create<Statement>();
+        read_fields(file, statement, alloc);
+
+        if (!intact(file)) { discard(alloc, statement); statement = nullptr; }
+    }
+
+    template<typename T>
+    void deserialize(Statement** data, T& file)
+    {
+        heap_alloc alloc;
+        deserialize_statement(data, file, alloc);
+    }
+
+    template<typename T>
+    void deserialize(Statement** data, T& file, Arena& arena)
+    {
+        deserialize_statement(data, file, arena);
+    }
+
+    void serialize(const Statement* data, ByteSink& out)
+    {
+        write_model_header<Statement>(out);
+        write_fields(out, data);
+    }
+
+    //  DataTagTable
+    /**
+     * @brief Reads the record at the current position into a row of the table.
+     * 
+     * Strings are only read far enough to be looked up in the dictionaries, so one
+     * scratch buffer serves every field.
+     */
+    template<typename T>
+    static void read_row(T& file, DataTagTable& table, c_uint row, std::string& scratch)
+    {
+        // The string fields are the columns, in schema order
+        static_assert(DataTagTable::COLUMNS == schema::model<DataTag>::layout::strings,
+                      "every string field of a DataTag needs a column");
+
+        bool whole = true;
+        schema::visit<DataTag>([&](auto field)
+        {
+            typedef decltype(field) F;
+            if (!whole) return;
+
+            if constexpr (F::type == schema::INT)
+                filemethods::read(file, &table.sequence[row]);
+            else if constexpr (F::type == schema::FLOAT)
+                filemethods::read(file, &table.value[row]);
+            else
+            {
+                // Extra length word in front of every DataTag string
+                filemethods::read<unsigned int>(file);
+
+                // A length the rest of the source can't hold gives up on the row, the source
+                // is left cut off so the caller stops there
+                const unsigned int size = filemethods::read<unsigned int>(file);
+                if (!(whole = filemethods::fits_length(file, size))) return;
+
+                scratch.resize(size);
+                filemethods::read_bytes(file, &scratch[0], size);
+
+                table.codes[F::index][row] = table.dictionaries[F::index].encode(scratch);
+            }
+        });
+    }
+
+    static void read_row(ByteSource& file, DataTagTable& table, c_uint row, std::string& scratch)
+    {
+        record_cursor cursor = { file.current() };
+        read_row(cursor, table, row, scratch);
+        file.position = cursor.at - file.data;
+    }
+
+    template<typename T>
+    void deserialize(DataTagTable& table, T& file)
+    {
+        assert(file);
+        metrics::scope timed(metrics::DESERIALIZE_TIME);
+        trace::scope   traced("deserialize");
+
+        const unsigned int count = read_tag_header(file);
+
+        // Every record that passes the check fits in here, a bogus count doesn't
+        const unsigned int most = most_records<DataTag>(file, count);
+
+        table.clear();
+        table.value.resize(most);
+        table.sequence.resize(most);
+        for (int c = 0; c < DataTagTable::COLUMNS; c++)
+            table.codes[c].resize(most);
 
-        // Get the count of fields (though this should always be the same so long
-        // as the Statement type is being populated)
-        unsigned int count = filemethods::read<unsigned int>(file);
+        std::string scratch;
 
-        for (int i = 0; i < count - 1; i++)
+        unsigned int rows = 0;
+        while (rows < count && rows < most && check_record<DataTag>(file))
         {
-            // The third object is an integer in the file
-            if (i == 3) filemethods::read(file, &statement->fiscal_year);
+            read_row(file, table, rows, scratch);
+            if (!intact(file)) break;
 
-            // Everything else is a string field. So pull the next string from the file
-            filemethods::read(file, GET_STRING(str_iter, i));
+            rows++;
         }
+
+        // A record past the ones that could fit still marks a short file
+        if (rows == most && rows < count) check_record<DataTag>(file);
+
+        // A short file ends the table at its last whole record
+        if (rows == table.value.size()) return;
+
+        table.value.resize(rows);
+        table.sequence.resize(rows);
+        for (int c = 0; c < DataTagTable::COLUMNS; c++)
+            table.codes[c].resize(rows);
     }
 
+    template void deserialize<std::ifstream>(DataTagTable&, std::ifstream&);
+    template void deserialize<Cloud::File*>(DataTagTable&, Cloud::File*&);
+    template void deserialize<ByteSource>(DataTagTable&, ByteSource&);
+
     // Define template types
     TEMP_TYPES(Company**);
     TEMP_TYPES(Statement**);
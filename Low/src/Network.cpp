@@ -1,6 +1,5 @@
 #include "finapi/finapi.h"
 
-#define _FIN_DEBUG
 #ifdef _FIN_WINDOWS
 
 int inet_pton(int af, const char *src, void *dst)
@@ -31,6 +30,9 @@ int inet_pton(int af, const char *src, void *dst)
 
 #   include <net/if.h>      // mac address things
 #   include <sys/ioctl.h>   // ioctl
+#   include <netinet/tcp.h> // TCP_NODELAY
+#   include <fcntl.h>       // O_NONBLOCK
+#   include <poll.h>        // poll
 
 #endif
 
@@ -104,28 +106,76 @@ namespace network
         return socket(AF_INET, SOCK_STREAM, 0);
     }
 
+    Transport& transport()
+    {
+        static Transport instance;
+        return instance;
+    }
+
     int set_options(const int sock) 
     {
-        int opt;
+        const int on = 1;
+
+        if ( setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (char*)&on, sizeof(int)) )
+            return 0;
 
-        if ( setsockopt(sock, SOL_SOCKET, SOCK_OPT, (char*)&opt, sizeof(int)) )
+    #ifdef SO_REUSEPORT
+        if ( setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (char*)&on, sizeof(int)) )
             return 0;
+    #endif
+
         return 1;
     }
 
+    static int set_timeout(const int sock, const int option, c_uint milliseconds)
+    {
+    #ifdef _FIN_WINDOWS
+        const DWORD timeout = milliseconds;
+    #else
+        timeval timeout;
+        timeout.tv_sec  = milliseconds / 1000;
+        timeout.tv_usec = (milliseconds % 1000) * 1000;
+    #endif
+
+        return !setsockopt(sock, SOL_SOCKET, option, (char*)&timeout, sizeof(timeout));
+    }
+
+    int tune_socket(const int sock)
+    {
+        const Transport& options = transport();
+        const int        on      = 1;
+        int              r       = 1;
+
+        if (options.no_delay)
+            r &= !setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char*)&on, sizeof(int));
+        if (options.keep_alive)
+            r &= !setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, (char*)&on, sizeof(int));
+
+        // The buffers have to be sized before connecting, the window scale is agreed on
+        // during the handshake
+        if (options.receive_buffer > 0)
+            r &= !setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char*)&options.receive_buffer, sizeof(int));
+        if (options.send_buffer > 0)
+            r &= !setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (char*)&options.send_buffer, sizeof(int));
+
+        // A send or receive that runs into its timeout fails like a dropped connection
+        if (options.send_timeout)
+            r &= set_timeout(sock, SO_SNDTIMEO, options.send_timeout);
+        if (options.recv_timeout)
+            r &= set_timeout(sock, SO_RCVTIMEO, options.recv_timeout);
+
+        return r;
+    }
+
     sockaddr_in* bind_socket(const int sock, const int port)
     {
-        sockaddr_in* address = new sockaddr_in;
-        int sock_len = sizeof(address);
+        // Allocated the way object frees it
+        sockaddr_in* address = _ALLOC(sizeof(sockaddr_in), sockaddr_in*);
 
         address->sin_family = AF_INET;
         address->sin_addr.s_addr = INADDR_ANY;
         address->sin_port = htons(port);
 
-    #ifdef _FIN_DEBUG
-        std::cout << "Binding socket " << sock << " to port " << port << "\n";
-    #endif
-
         if ( bind(sock, (struct sockaddr*)address, sizeof(sockaddr_in)) != 0 )
         {
             std::free(address);
@@ -147,106 +197,376 @@ namespace network
         return accept(sock, (sockaddr*)in, (socklen_t*)addr_len);
     }
 
+    /**
+     * @brief Splits an "ip:port" string, the port defaults to _FIN_PORT.
+     */
+    static bool split_address(const char* address, std::string& ip, int& port)
+    {
+        const char* colon = std::strchr(address, ':');
+        if (!colon)
+            { ip = address; port = _FIN_PORT; return true; }
+
+        ip.assign(address, colon - address);
+        port = std::atoi(colon + 1);
+        return (port > 0 && port <= 65535);
+    }
+
+    int parse_address(const char* address, sockaddr_in* dest)
+    {
+        std::string ip;
+        int port;
+        if (!split_address(address, ip, port)) return 0;
+
+        std::memset(dest, 0, sizeof(sockaddr_in));
+        dest->sin_family = AF_INET;
+        dest->sin_port   = htons(port);
+
+        return (inet_pton(AF_INET, ip.c_str(), &dest->sin_addr) > 0);
+    }
+
     int connect_to_ip(const int sock, const char* ip, const int port)
     {
         sockaddr_in serv_addr;
+        std::memset(&serv_addr, 0, sizeof(serv_addr));
         serv_addr.sin_family = AF_INET;
         serv_addr.sin_port   = htons(port);
 
         if (inet_pton(AF_INET, ip, &serv_addr.sin_addr) <= 0)
             return 0;
-        
-        sockaddr_in* addr;
-        for (int lower = 9000; lower <= 10000 && !addr; lower++)
-            addr = bind_socket(sock, lower);
 
-        if (!addr) 
-        {
-        #ifdef _FIN_DEBUG
-            std::cout << "Failed to bind a port!\n";
-        #endif
+        // Nothing is bound up front, connect() takes an ephemeral port itself
+        const unsigned int timeout = transport().connect_timeout;
+
+    #ifdef _FIN_WINDOWS
+        return (connect(sock, (sockaddr*)&serv_addr, sizeof(serv_addr)) == 0);
+    #else
+        if (!timeout)
+            return (connect(sock, (sockaddr*)&serv_addr, sizeof(serv_addr)) == 0);
+
+        const int flags = fcntl(sock, F_GETFL, 0);
+        if (flags < 0 || fcntl(sock, F_SETFL, flags | O_NONBLOCK) < 0)
             return 0;
-        }
 
-        if (connect(sock, (sockaddr*)&serv_addr, sizeof(sockaddr)) < 0)
+        int connected = (connect(sock, (sockaddr*)&serv_addr, sizeof(serv_addr)) == 0);
+
+        if (!connected && errno == EINPROGRESS)
         {
-        #ifdef _FIN_DEBUG
-            std::cout << "Connection failed with error code " << errno << ": " << strerror(errno) << "\n";
-        #endif
+            // Wait for the handshake until the deadline, a signal only shortens the wait
+            const std::chrono::steady_clock::time_point deadline =
+                std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+            pollfd fd = { sock, POLLOUT, 0 };
+            int ready;
+            do
+            {
+                const long long left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now()).count();
+                ready = poll(&fd, 1, std::max(0LL, left));
+            } while (ready < 0 && errno == EINTR);
+
+            int       error  = 0;
+            socklen_t length = sizeof(error);
+            connected = (ready == 1 && getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && !error);
+        }
+
+        // The rest of the client works on blocking sockets
+        if (fcntl(sock, F_SETFL, flags) < 0)
             return 0;
+
+        return connected;
+    #endif
+    }
+
+    int send_all(const int sock, const char* data, const int size)
+    {
+        int sent = 0;
+        while (sent < size)
+        {
+            const int r = send(sock, data + sent, size - sent, _FIN_SEND_FLAGS);
+            if (r <= 0) return 0;
+            sent += r;
         }
 
+        metrics::add(metrics::BYTES_SENT, sent);
         return 1;
     }
 
+    int recv_all(const int sock, char* dest, const int size)
+    {
+        int received = 0;
+        while (received < size)
+        {
+            // MSG_WAITALL lets the kernel fill the whole frame in one call, but a signal
+            // or a closing peer can still cut it short
+            const int r = recv(sock, dest + received, size - received, MSG_WAITALL);
+            if (r <= 0) break;
+            received += r;
+        }
+
+        metrics::add(metrics::BYTES_RECEIVED, received);
+        return received;
+    }
+
     int connect_socket(const char* address)
     {
+        std::string ip;
+        int port;
+        if (!split_address(address, ip, port)) return -2;
+
         int sock = make_socket();
         if (sock < 0) return -1;
 
-        if (!connect_to_ip(sock, address, 1420))
+        tune_socket(sock);
+
+        trace::scope traced("connect");
+        const metrics::clock::time_point start = metrics::clock::now();
+
+        if (!connect_to_ip(sock, ip.c_str(), port))
         {
+            metrics::add(metrics::CONNECT_FAILURES);
             close(sock);
             return -2;
         }
-        
+
+        metrics::record(metrics::CONNECT_TIME, start);
+        metrics::add(metrics::CONNECTS);
         return sock;
     }
 }
 
 namespace Cloud
 {
+    /**
+     * @brief Progress of a file that is still streaming in.
+     * 
+     * Chunks may finish in any order, the watermark only moves over the ones that have
+     * arrived without a gap since the start of the file.
+     */
+    struct File::download
+    {
+        File*             file;
+        std::string       filename;
+        std::string       address;
+        unsigned int      chunks;
+
+        std::mutex              mutex;
+        std::condition_variable progress;
+        std::vector<char>       arrived;
+        unsigned int            next;
+        unsigned int            remaining;
+        Status                  failure;
+        bool                    finished;
+
+        std::atomic<unsigned>   watermark;
+
+        download(File* file, const char* filename, const char* address, c_uint chunks) :
+            file(file), filename(filename), address(address), chunks(chunks),
+            arrived(chunks, 0), next(0), remaining(chunks), failure(OK), finished(!chunks), watermark(0)
+        {   }
+
+        /**
+         * @brief Marks chunks as done, either arrived or given up on.
+         */
+        void complete(c_uint first, c_uint count, const Status status)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            for (unsigned int i = first; i < first + count; i++)
+                arrived[i] = (status == OK);
+
+            if (status != OK) failure = status;
+
+            while (next < chunks && arrived[next]) next++;
+            watermark.store(std::min<unsigned int>(next * _FIN_BUFFER_SIZE, file->filesize), std::memory_order_release);
+
+            remaining -= count;
+            if (!remaining)
+            {
+                trace::scope traced("assemble", filename.c_str());
+
+                // Nobody can free the file before it is finished, so the buffer can be
+                // stored without holding up readers of the bytes that already arrived
+                if (failure == OK && cache().enabled())
+                {
+                    lock.unlock();
+                    cache().store(address.c_str(), filename.c_str(), file->buffer, file->filesize, chunks);
+                    lock.lock();
+                }
+
+                finish();
+            }
+
+            progress.notify_all();
+        }
+
+        /**
+         * @brief Seals the file once every chunk is done, the mutex must be held.
+         */
+        void finish()
+        {
+            file->status = failure;
+            *(file->buffer + file->filesize) = '\0';
+            finished = true;
+        }
+    };
+
     File::File(Status s) :
-        iterator(0), filesize(0), status(s), buffer(nullptr)
+        status(s), filesize(0), buffer(nullptr), iterator(0), stream(nullptr), mapping(nullptr)
     {   }
 
     File::File(c_uint size) :
-        iterator(0), status(OK), filesize(size), buffer( CHAR_ALLOC(size) )
+        status(OK), filesize(size), buffer( CHAR_ALLOC(size + 1) ), iterator(0), stream(nullptr), mapping(nullptr)
+    {   }
+
+    File::File(MappedFile* mapping, c_uint offset, c_uint size) :
+        status(OK), filesize(size), buffer( (char*)mapping->data() + offset ), iterator(0), stream(nullptr), mapping(mapping)
     {   }
 
     void File::read(void* ptr, c_uint size)
     {
-        std::memcpy(ptr, buffer + iterator, size);
+        if (size <= filesize - iterator)
+        {
+            std::memcpy(ptr, read_span(size), size);
+            return;
+        }
+
+        // The file ends before the read does, hand out what there is and zeros after it
+        const unsigned int have = filesize - iterator;
+        std::memcpy(ptr, read_span(have), have);
+        std::memset((char*)ptr + have, 0, size - have);
+        status = PARTIAL;
+    }
+
+    const char* File::read_span(c_uint size)
+    {
+        if (size > filesize - iterator)
+        {
+            iterator = filesize;
+            status   = PARTIAL;
+            return nullptr;
+        }
+
+        if (stream && iterator + size > stream->watermark.load(std::memory_order_acquire))
+            wait_for(iterator + size);
+
+        const char* r = buffer + iterator;
         iterator += size;
+        return r;
+    }
+
+    void File::skip(c_uint size)
+    {
+        read_span(size);
+    }
+
+    void File::wait_for(c_uint end)
+    {
+        std::unique_lock<std::mutex> lock(stream->mutex);
+        stream->progress.wait(lock, [this, end]()
+            { return stream->finished || stream->watermark.load(std::memory_order_relaxed) >= end; });
+
+        // A chunk was lost for good, hand out zeros instead of whatever the buffer holds
+        const unsigned int have = stream->watermark.load(std::memory_order_relaxed);
+        if (have < end && iterator < std::min(end, filesize))
+            std::memset(buffer + std::max(iterator, have), 0, std::min(end, filesize) - std::max(iterator, have));
+    }
+
+    ByteSource File::source()
+    {
+        wait();
+
+        ByteSource r(buffer, filesize);
+        r.position = iterator;
+        return r;
+    }
+
+    unsigned int File::available() const
+    {
+        return (stream ? stream->watermark.load(std::memory_order_acquire) : filesize);
+    }
+
+    void File::wait()
+    {
+        if (!stream) return;
+
+        std::unique_lock<std::mutex> lock(stream->mutex);
+        stream->progress.wait(lock, [this]() { return stream->finished; });
     }
 
     File::~File()
-    { std::free(buffer); }
+    {
+        // The workers write into the buffer until the download is done
+        wait();
+        delete stream;
+
+        if (mapping)
+            delete mapping;
+        else
+            std::free(buffer);
+    }
 
-    void make_request(const char* command, const int socket, char* buffer, int size)
+    int make_request(const char* command, const int socket, char* buffer, int size)
     {
-        // Get start time for debugging
-        time_point(start);
+        trace::scope traced(metrics::name(metrics::command_histogram(command)));
+        const metrics::clock::time_point start = metrics::clock::now();
 
         // Set the size of the client buffer
         if (size == -1) size = _FIN_BUFFER_SIZE;
 
-        // Send the command to the server
-        send(socket, command, strlen(command), 0);
+        // Send the command to the server and receive whatever comes back first
+        if (!network::send_all(socket, command, strlen(command)))
+            return -1;
 
-        // Zero out the client buffer and receive incoming info
-        std::memset(buffer, 0, size);
-        recv(socket, buffer, size, 0);
+        const int received = recv(socket, buffer, size, 0);
 
-        time_point(stop);
-        logmsg_micros("Request made and received in ");
+        metrics::record(metrics::command_histogram(command), start);
+        metrics::add(metrics::COMMANDS);
+        if (received > 0) metrics::add(metrics::BYTES_RECEIVED, received);
+
+        return received;
     }
 
     std::string make_request(const char* command, const int socket)
     {
-        char* buffer = (char*)std::malloc(_FIN_BUFFER_SIZE);
-        make_request(command, socket, buffer);
-        std::string r = buffer;
-        std::free(buffer);
-        return r;
+        char buffer[_FIN_BUFFER_SIZE];
+        const int received = make_request(command, socket, buffer);
+        if (received <= 0) return "";
+
+        return std::string(buffer, strnlen(buffer, received));
     }
 
     std::string make_request(const char* command, const char* address)
     {
-        int socket = network::connect_socket(address);
-        std::string r = make_request(command, socket);
-        close(socket);
-        return r;
+        int socket;
+        if (pool().checkout(address, socket) != OK)
+            return "";
+
+        char buffer[_FIN_BUFFER_SIZE];
+        const int received = make_request(command, socket, buffer);
+
+        if (received > 0)
+            pool().checkin(address, socket);
+        else
+            { pool().discard(address, socket); return ""; }
+
+        return std::string(buffer, strnlen(buffer, received));
+    }
+
+    Status request_frame(const char* command, const int socket, char* dest, const int size)
+    {
+        trace::scope traced(metrics::name(metrics::command_histogram(command)));
+        const metrics::clock::time_point start = metrics::clock::now();
+
+        if (!network::send_all(socket, command, strlen(command)))
+            return SOCKET_FAIL;
+
+        const int received = network::recv_all(socket, dest, size);
+
+        metrics::record(metrics::command_histogram(command), start);
+        metrics::add(metrics::COMMANDS);
+
+        if (received == size) return OK;
+        return (received > 0 ? PARTIAL : SOCKET_FAIL);
     }
 
     bool file_exists(const char* filename, const char* address)
@@ -254,60 +574,391 @@ namespace Cloud
         return (make_request(network::str_concat("exists ", filename).c_str(), address) == "T");
     }
 
-    void request_file(const char* filename, const int i, const int filesize, char* buffer, const char* address)
+    /**
+     * @brief Receives the reply of a single chunk, unpacking it on compressed sessions.
+     */
+    static Status receive_chunk(const int sock, char* dest, const int length, const bool compressed)
+    {
+        if (!compressed)
+        {
+            const int received = network::recv_all(sock, dest, length);
+            if (received == length) return OK;
+            return (received > 0 ? PARTIAL : SOCKET_FAIL);
+        }
+
+        char stored[sizeof(compress::block_header)];
+        const int received = network::recv_all(sock, stored, sizeof(stored));
+        if (received != sizeof(stored))
+            return (received > 0 ? PARTIAL : SOCKET_FAIL);
+
+        const compress::block_header header = compress::load_header(stored);
+
+        // A block that doesn't fit the chunk leaves the stream out of step, the socket is lost
+        if (header.raw != (unsigned int)length || header.size > header.raw)
+            return PARTIAL;
+
+        if (header.size == header.raw)
+            return (network::recv_all(sock, dest, length) == length ? OK : PARTIAL);
+
+        char payload[_FIN_BUFFER_SIZE];
+        if (network::recv_all(sock, payload, header.size) != (int)header.size)
+            return PARTIAL;
+
+        return (compress::read_block(header, payload, dest) ? OK : PARTIAL);
+    }
+
+    Status request_file(const char* filename, const int i, const int filesize, char* buffer, const char* address)
     {
-        int sock = network::connect_socket(address);
+        trace::scope traced("chunk", filename, i);
 
-        if (make_request("LOGIN ADMIN ADMIN123", address) != "OK")
-            { close(sock); return; }
+        int sock;
+        const Status status = pool().checkout(address, sock);
+        if (status != OK)
+            return status;
+
+        // The server sends the file along with a trailing byte, so the last chunk runs up to filesize + 1
+        const int length = std::min(_FIN_BUFFER_SIZE, filesize + 1 - _FIN_BUFFER_SIZE * i);
 
         std::string command = network::str_concat("REQ ", filename, " ", std::to_string(i));
-        make_request(command.c_str(), sock, buffer + (_FIN_BUFFER_SIZE * i), filesize);
-        
-        close(sock);
+
+        // Anything short of the full chunk leaves the rest of the reply in the socket, so
+        // the connection can't be handed to the next request
+        const metrics::clock::time_point start = metrics::clock::now();
+
+        bool sent;
+        {
+            trace::scope request("request");
+            sent = network::send_all(sock, command.c_str(), command.size());
+        }
+
+        Status received = SOCKET_FAIL;
+        if (sent)
+        {
+            trace::scope receive("receive");
+            received = receive_chunk(sock, buffer + (_FIN_BUFFER_SIZE * i), length, pool().compressed(sock));
+        }
+
+        metrics::record(metrics::CHUNK_TIME, start);
+        metrics::add(metrics::COMMANDS);
+
+        if (received == OK)
+        {
+            metrics::add(metrics::CHUNKS);
+            pool().checkin(address, sock);
+        }
+        else
+        {
+            metrics::add(metrics::CHUNK_FAILURES);
+            pool().discard(address, sock);
+        }
+
+        return received;
     }
 
-    void get_file(const char* filename, const char* address, File*& file)
+    Status request_range(const char* filename, const int first, const int count, const int filesize, char* buffer, const char* address, int* completed)
     {
-        time_point(start);
+        if (completed) *completed = 0;
+
+        trace::scope traced("range", filename, first);
+
+        int sock;
+        const Status status = pool().checkout(address, sock);
+        if (status != OK)
+            return status;
+
+        // The replies of every chunk in the range come back to back, ending early at the last chunk
+        const int offset = _FIN_BUFFER_SIZE * first;
+        const int length = std::min(_FIN_BUFFER_SIZE * count, filesize + 1 - offset);
+
+        std::string command = network::str_concat("REQ ", filename, " ", std::to_string(first), " ", std::to_string(count));
+
+        const metrics::clock::time_point start = metrics::clock::now();
+        metrics::add(metrics::COMMANDS);
+
+        bool sent;
+        {
+            trace::scope request("request");
+            sent = network::send_all(sock, command.c_str(), command.size());
+        }
 
-        int sock = network::connect_socket(address);
+        if (!sent)
+            { metrics::add(metrics::CHUNK_FAILURES); pool().discard(address, sock); return SOCKET_FAIL; }
 
-        if (sock < 0)
-            { file = new File(SOCKET_FAIL); return; }
+        trace::scope receive("receive");
+
+        if (pool().compressed(sock))
+        {
+            // Every chunk is a block of its own
+            int done = 0;
+            Status received = OK;
+
+            for (; done < count; done++)
+            {
+                const int chunk = std::min(_FIN_BUFFER_SIZE, length - _FIN_BUFFER_SIZE * done);
+                if ((received = receive_chunk(sock, buffer + offset + _FIN_BUFFER_SIZE * done, chunk, true)) != OK)
+                    break;
+            }
+
+            if (completed) *completed = done;
+
+            metrics::record(metrics::CHUNK_TIME, start);
+            metrics::add(metrics::CHUNKS, done);
+            if (received != OK) metrics::add(metrics::CHUNK_FAILURES);
+
+            if (received == OK)
+                pool().checkin(address, sock);
+            else
+                pool().discard(address, sock);
+
+            return (received == OK || !done ? received : PARTIAL);
+        }
+
+        const int received = network::recv_all(sock, buffer + offset, length);
+        metrics::record(metrics::CHUNK_TIME, start);
+
+        if (received == length)
+        {
+            metrics::add(metrics::CHUNKS, count);
+            pool().checkin(address, sock);
+            if (completed) *completed = count;
+            return OK;
+        }
+
+        pool().discard(address, sock);
+
+        // Only the chunks that arrived in full count, the caller retries from the first broken one.
+        // A reply running past the range can't add chunks that weren't asked for
+        const int whole = std::min(count, std::max(received, 0) / _FIN_BUFFER_SIZE);
+        metrics::add(metrics::CHUNKS, whole);
+        metrics::add(metrics::CHUNK_FAILURES);
+        if (completed) *completed = whole;
+        return (received > 0 ? PARTIAL : SOCKET_FAIL);
+    }
+
+    Options& options()
+    {
+        static Options instance;
+        return instance;
+    }
+
+    /**
+     * @brief Queries a file over a session that is already checked out.
+     * 
+     * SOCKET_FAIL and PARTIAL leave the session unusable, it has to be discarded.
+     */
+    static Status file_info(const char* filename, const int sock, unsigned int& filesize, unsigned int& chunks)
+    {
+        trace::scope traced("metadata", filename);
 
         if (make_request(network::str_concat("exists ", filename).c_str(), sock) == "F")
-            { close(sock); file = new File(DNE); return; }
+            return DNE;
+
+        Status size_read = request_frame(network::str_concat("SZE ", filename).c_str(), sock, (char*)&filesize, sizeof(unsigned int));
+        if (size_read == OK)
+            size_read = request_frame(network::str_concat("CHK ", filename).c_str(), sock, (char*)&chunks, sizeof(unsigned int));
+
+        if (size_read != OK)
+            return size_read;
+
+        // The size counts the trailing byte and the chunks have to cover exactly that, any
+        // other reply can't be trusted to size a buffer with, nor the session it came over
+        if (!filesize || filesize > INT_MAX || chunks != (filesize - 1) / _FIN_BUFFER_SIZE + 1)
+            return PARTIAL;
 
-        unsigned int filesize, chunks;
-        make_request(network::str_concat("SZE ", filename).c_str(), sock, (char*)&filesize, sizeof(unsigned int));
-        make_request(network::str_concat("CHK ", filename).c_str(), sock, (char*)&chunks,   sizeof(unsigned int));
         filesize -= 1;
+        return OK;
+    }
 
-        close(sock);
+    Status file_info(const char* filename, const char* address, unsigned int& filesize, unsigned int& chunks)
+    {
+        int sock;
+        const Status status = pool().checkout(address, sock);
+
+        if (status != OK)
+            return status;
+
+        const Status info = file_info(filename, sock, filesize, chunks);
+
+        if (info == OK || info == DNE)
+            pool().checkin(address, sock);
+        else
+            pool().discard(address, sock);
+
+        return info;
+    }
+
+    void File::begin(File*& file, const char* filename, const char* address, c_uint filesize, c_uint chunks)
+    {
+        if (cache().enabled() && (file = cache().lookup(address, filename, filesize, chunks)))
+            return;
 
         file = new File(filesize);
 
-        std::vector<std::thread*> threads;
-        threads.reserve(chunks);
+        // The download keeps its own copy of the names, the caller's may be gone by the
+        // time the last chunk is pulled
+        File::download* dl = new File::download(file, filename, address, chunks);
+        file->stream = dl;
 
-        for (int i = 0; i < chunks; i++)
-            threads.push_back(new std::thread(request_file, filename, i, filesize, file->buffer, address));
+        if (!chunks)
+            { std::lock_guard<std::mutex> lock(dl->mutex); dl->finish(); return; }
 
-    #ifdef _FIN_DEBUG
-        std::cout << "There are " << threads.size() << " threads.\n";
-    #endif
+        // Every chunk goes through the shared executor, so the amount of threads (and
+        // therefore of sockets) stays bounded no matter how large the file is
+        char* buffer = file->buffer;
+
+        // Pulls a single chunk, trying again a few times if the frame comes back broken
+        auto fetch_chunk = [dl, filesize, buffer](const int i)
+        {
+            Status status = OK;
+            for (int attempt = 0; attempt <= _FIN_CHUNK_RETRIES; attempt++)
+            {
+                if (attempt) metrics::add(metrics::CHUNK_RETRIES);
+                if ((status = request_file(dl->filename.c_str(), i, filesize, buffer, dl->address.c_str())) == OK)
+                    break;
+            }
+            dl->complete(i, 1, status);
+        };
+
+        if (options().pipelined)
+        {
+            // One ranged request per session, each streaming pipeline_depth chunks
+            const unsigned int depth = std::max(1u, options().pipeline_depth);
+            for (unsigned int i = 0; i < chunks; i += depth)
+            {
+                // Chunk numbers go on the wire as ints, a file has far fewer than INT_MAX
+                const int first = (int)i;
+                const int count = (int)std::min(depth, chunks - i);
+                downloads().submit([=]()
+                {
+                    int completed;
+                    const Status status = request_range(dl->filename.c_str(), first, count, filesize, buffer, dl->address.c_str(), &completed);
+
+                    if (completed) dl->complete(first, completed, OK);
+                    if (status == OK) return;
+
+                    // Fall back to pulling the rest of the range one chunk at a time
+                    for (int j = first + completed; j < first + count; j++)
+                        fetch_chunk(j);
+                });
+            }
+        }
+        else
+        {
+            for (unsigned int i = 0; i < chunks; i++)
+                downloads().submit([=]() { fetch_chunk((int)i); });
+        }
+    }
+
+    void stream_file(const char* filename, const char* address, File*& file)
+    {
+        unsigned int filesize, chunks;
+        const Status status = file_info(filename, address, filesize, chunks);
+
+        if (status != OK)
+            { file = new File(status); return; }
+
+        File::begin(file, filename, address, filesize, chunks);
+    }
+
+    std::vector<Status> get_files(const std::vector<std::string>& filenames, const char* address, std::unordered_map<std::string, File*>& files)
+    {
+        metrics::scope timed(metrics::FILE_TIME);
+        trace::scope   traced("get_files");
+
+        struct info
+        {
+            const std::string* name;
+            Status             status;
+            unsigned int       filesize;
+            unsigned int       chunks;
+        };
+
+        // An entry without a file is pulled like a name that isn't in the map at all
+        for (const std::string& name : filenames)
+        {
+            const auto entry = files.find(name);
+            if (entry != files.end() && !entry->second) files.erase(entry);
+        }
+
+        std::vector<info> unique;
+        for (const std::string& name : filenames)
+            if (files.emplace(name, nullptr).second)
+                unique.push_back({ &name, EMPTY, 0, 0 });
+
+        // Each session queries its share of the files back to back, the protocol can't
+        // have more than one request in flight per socket
+        const unsigned int sessions = std::min<unsigned int>(unique.size(), _FIN_METADATA_SESSIONS);
+
+        TaskGroup queried;
+
+        for (unsigned int s = 0; s < sessions; s++)
+        {
+            downloads().submit([&unique, address, sessions, s]()
+            {
+                int sock = -1;
+                for (unsigned int i = s; i < unique.size(); i += sessions)
+                {
+                    info& f = unique[i];
+
+                    if (sock < 0)
+                    {
+                        const Status status = pool().checkout(address, sock);
+                        if (status != OK)
+                            { f.status = status; sock = -1; continue; }
+                    }
+
+                    f.status = file_info(f.name->c_str(), sock, f.filesize, f.chunks);
+                    if (f.status != OK && f.status != DNE)
+                        { pool().discard(address, sock); sock = -1; }
+                }
+
+                if (sock >= 0) pool().checkin(address, sock);
+            }, &queried);
+        }
+
+        queried.wait();
 
-        for (int i = 0; i < threads.size(); i++)
+        // Every chunk of every file competes for the same download workers
+        for (info& f : unique)
         {
-            threads[i]->join();
-            delete threads[i];
+            File*& file = files[*f.name];
+            if (f.status != OK)
+                file = new File(f.status);
+            else
+                File::begin(file, f.name->c_str(), address, f.filesize, f.chunks);
+        }
+
+        std::vector<Status> r;
+        r.reserve(filenames.size());
+
+        for (const std::string& name : filenames)
+        {
+            File* file = files[name];
+            file->wait();
+            r.push_back(file->status);
         }
 
-        *(file->buffer + file->filesize) = '\0';
+        return r;
+    }
+
+    void get_file(const char* filename, const char* address, File*& file)
+    {
+        metrics::scope timed(metrics::FILE_TIME);
+        trace::scope   traced("get_file", filename);
+
+        stream_file(filename, address, file);
+        file->wait();
+    }
 
-        time_point(stop);
-        logmsg_ms("File received in ");
+    ThreadPool& downloads()
+    {
+        static ThreadPool executor(_FIN_DOWNLOAD_WORKERS);
+        return executor;
+    }
+
+    void set_download_workers(c_uint workers)
+    {
+        downloads().resize(workers ? workers : _FIN_DOWNLOAD_WORKERS);
     }
 
     void get_file(const char* filename, Address address, File*& file)
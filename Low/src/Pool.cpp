@@ -0,0 +1,196 @@
+#include "finapi/finapi.h"
+
+#ifndef _FIN_WINDOWS
+#   include <poll.h>
+#endif
+
+namespace finapi
+{
+namespace Cloud
+{
+    ConnectionPool::ConnectionPool(c_uint max_size, c_uint idle_seconds) :
+        max_size(max_size), idle_timeout(idle_seconds)
+    {   }
+
+    ConnectionPool::~ConnectionPool()
+    {
+        clear();
+    }
+
+    Status ConnectionPool::checkout(const char* address, int& socket)
+    {
+        trace::scope traced("checkout");
+
+        std::unique_lock<std::mutex> lock(mutex);
+        endpoint& ep = endpoints[address];
+
+        for (;;)
+        {
+            evict(ep, clock::now());
+
+            // Hand out the most recently used socket first, it's the least likely
+            // to have been dropped by the server
+            while (!ep.idle.empty())
+            {
+                const int sock = ep.idle.back().socket;
+                ep.idle.pop_back();
+
+                if (healthy(sock))
+                    { socket = sock; return OK; }
+
+                close_socket(sock);
+                ep.open--;
+            }
+
+            if (ep.open < max_size) break;
+
+            returned.wait(lock);
+        }
+
+        // Reserve the slot before connecting so other threads can't overshoot the limit
+        ep.open++;
+        lock.unlock();
+
+        Status status = OK;
+        int sock = network::connect_socket(address);
+
+        if (sock == -1)
+            status = SOCKET_FAIL;
+        else if (sock < 0)
+            status = CONNECT_FAIL;
+        else if (make_request("LOGIN ADMIN ADMIN123", sock) != "OK")
+            { close(sock); status = LOGIN_FAIL; metrics::add(metrics::LOGIN_FAILURES); }
+
+        // Compression is agreed on once per session, a declined request leaves it raw
+        const bool compress = (status == OK && options().compressed && make_request("COMPRESS", sock) == "OK");
+
+        lock.lock();
+
+        if (status != OK)
+        {
+            ep.open--;
+            returned.notify_one();
+            return status;
+        }
+
+        if (compress) compressing[sock] = true;
+
+        socket = sock;
+        return OK;
+    }
+
+    void ConnectionPool::checkin(const char* address, const int socket)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        endpoint& ep = endpoints[address];
+
+        ep.idle.push_back({ socket, clock::now() });
+        returned.notify_one();
+    }
+
+    void ConnectionPool::discard(const char* address, const int socket)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        close_socket(socket);
+
+        endpoints[address].open--;
+        returned.notify_one();
+    }
+
+    void ConnectionPool::evict_idle()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const clock::time_point now = clock::now();
+
+        for (auto& ep : endpoints)
+            evict(ep.second, now);
+    }
+
+    void ConnectionPool::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (auto& ep : endpoints)
+        {
+            for (const connection& c : ep.second.idle)
+                close_socket(c.socket);
+
+            ep.second.open -= ep.second.idle.size();
+            ep.second.idle.clear();
+        }
+
+        returned.notify_all();
+    }
+
+    void ConnectionPool::set_max_size(c_uint max_size)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->max_size = (max_size ? max_size : 1);
+        returned.notify_all();
+    }
+
+    void ConnectionPool::set_idle_timeout(c_uint seconds)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle_timeout = std::chrono::seconds(seconds);
+    }
+
+    unsigned int ConnectionPool::idle_count(const char* address)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return endpoints[address].idle.size();
+    }
+
+    unsigned int ConnectionPool::open_count(const char* address)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return endpoints[address].open;
+    }
+
+    void ConnectionPool::evict(endpoint& ep, const clock::time_point now)
+    {
+        // The idle list is ordered by return time, so everything past the timeout
+        // sits at the front
+        unsigned int expired = 0;
+        while (expired < ep.idle.size() && now - ep.idle[expired].last_used > idle_timeout)
+            close_socket(ep.idle[expired++].socket);
+
+        if (!expired) return;
+
+        ep.idle.erase(ep.idle.begin(), ep.idle.begin() + expired);
+        ep.open -= expired;
+        returned.notify_all();
+    }
+
+    bool ConnectionPool::compressed(const int socket)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return compressing.count(socket);
+    }
+
+    void ConnectionPool::close_socket(const int socket)
+    {
+        compressing.erase(socket);
+        close(socket);
+    }
+
+    bool ConnectionPool::healthy(const int socket)
+    {
+    #ifdef _FIN_WINDOWS
+        return true;
+    #else
+        // A readable idle socket either has been closed by the server (recv returns 0)
+        // or holds bytes nobody asked for, neither of which we want to hand out
+        pollfd fd = { socket, POLLIN, 0 };
+        if (poll(&fd, 1, 0) < 0) return false;
+        return !(fd.revents & (POLLIN | POLLERR | POLLHUP | POLLNVAL));
+    #endif
+    }
+
+    ConnectionPool& pool()
+    {
+        static ConnectionPool instance;
+        return instance;
+    }
+}
+}
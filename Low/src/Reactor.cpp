@@ -0,0 +1,470 @@
+#include "finapi/finapi.h"
+
+#ifdef _FIN_REACTOR
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <fcntl.h>
+#include <cerrno>
+
+namespace finapi
+{
+namespace Cloud
+{
+    struct Reactor::download
+    {
+        File*         file;
+        std::string   filename;
+        std::string   address;
+        file_callback callback;
+
+        unsigned int  chunks;
+        unsigned int  next;
+        unsigned int  remaining;
+        unsigned int  failures;
+        bool          starved;
+        bool          finished;
+
+        std::vector<unsigned int> retry;
+        std::vector<connection*>  conns;
+    };
+
+    struct Reactor::connection
+    {
+        enum phase
+        {
+            CONNECTING,
+            LOGIN,
+            AWAIT_LOGIN,
+            REQUEST,
+            RECEIVING
+        };
+
+        int          socket;
+        phase        state;
+        download*    dl;
+        int          chunk;
+
+        std::string  out;
+        unsigned int sent;
+
+        unsigned int offset;
+        unsigned int expected;
+        unsigned int received;
+
+        // Start of the current phase, for the metrics
+        metrics::clock::time_point since;
+    };
+
+    Reactor::Reactor(c_uint connections, c_uint max_connections) :
+        connections(connections ? connections : 1), max_connections(max_connections ? max_connections : 1),
+        open(0), in_flight(0), stopping(false)
+    {
+        poll_fd = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        epoll_event ev;
+        ev.events   = EPOLLIN;
+        ev.data.ptr = nullptr;
+        epoll_ctl(poll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
+
+        thread = std::thread(&Reactor::run, this);
+    }
+
+    Reactor::~Reactor()
+    {
+        stopping = true;
+
+        const uint64_t one = 1;
+        write(wake_fd, &one, sizeof(one));
+        thread.join();
+
+        close(wake_fd);
+        close(poll_fd);
+    }
+
+    void Reactor::get_file(const char* filename, const char* address, file_callback callback)
+    {
+        unsigned int filesize = 0, chunks = 0;
+        const Status status = file_info(filename, address, filesize, chunks);
+
+        // A failed query still goes through the reactor, so every callback runs on its thread
+        download* dl  = new download;
+        dl->file      = (status == OK ? new File(filesize) : new File(status));
+        dl->filename  = filename;
+        dl->address   = address;
+        dl->callback  = callback;
+        dl->chunks    = (status == OK ? chunks : 0);
+        dl->next      = 0;
+        dl->remaining = dl->chunks;
+        dl->failures  = 0;
+        dl->starved   = false;
+        dl->finished  = false;
+
+        in_flight++;
+
+        {
+            std::lock_guard<std::mutex> lock(incoming_mutex);
+            incoming.push_back(dl);
+        }
+
+        const uint64_t one = 1;
+        write(wake_fd, &one, sizeof(one));
+    }
+
+    std::future<File*> Reactor::get_file(const char* filename, const char* address)
+    {
+        std::shared_ptr<std::promise<File*>> promise = std::make_shared<std::promise<File*>>();
+        std::future<File*> r = promise->get_future();
+
+        get_file(filename, address, [promise](File* file) { promise->set_value(file); });
+
+        return r;
+    }
+
+    unsigned int Reactor::active()
+    {
+        return in_flight;
+    }
+
+    void Reactor::run()
+    {
+        const int MAX_EVENTS = 256;
+        epoll_event events[MAX_EVENTS];
+
+        while (!stopping)
+        {
+            const int count = epoll_wait(poll_fd, events, MAX_EVENTS, -1);
+
+            for (int i = 0; i < count; i++)
+            {
+                connection* c = (connection*)events[i].data.ptr;
+
+                if (!c)
+                {
+                    uint64_t value;
+                    read(wake_fd, &value, sizeof(value));
+
+                    std::vector<download*> added;
+                    {
+                        std::lock_guard<std::mutex> lock(incoming_mutex);
+                        added.swap(incoming);
+                    }
+
+                    for (download* dl : added)
+                        start(dl);
+
+                    continue;
+                }
+
+                if (c->socket < 0) continue;
+
+                if (events[i].events & (EPOLLERR | EPOLLHUP) && c->state != connection::RECEIVING)
+                    fail(c, c->state == connection::CONNECTING ? CONNECT_FAIL : SOCKET_FAIL);
+                else if (events[i].events & EPOLLOUT)
+                    on_writable(c);
+                else if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                    on_readable(c);
+            }
+
+            collect();
+        }
+
+        // Hand back whatever is still in flight as failed
+        {
+            std::lock_guard<std::mutex> lock(incoming_mutex);
+            downloads.insert(downloads.end(), incoming.begin(), incoming.end());
+            incoming.clear();
+        }
+
+        while (!downloads.empty())
+            finish(downloads.back(), SOCKET_FAIL);
+
+        collect();
+    }
+
+    void Reactor::collect()
+    {
+        for (connection* c : closed)
+            delete c;
+        closed.clear();
+
+        // Callbacks run last, once nothing refers to the downloads anymore
+        std::vector<download*> finished;
+        finished.swap(done);
+
+        for (download* dl : finished)
+        {
+            File* file = dl->file;
+            file_callback callback = dl->callback;
+            delete dl;
+
+            in_flight--;
+            callback(file);
+        }
+    }
+
+    void Reactor::start(download* dl)
+    {
+        downloads.push_back(dl);
+
+        if (!dl->remaining)
+            { finish(dl, dl->file->status); return; }
+
+        open_connections(dl);
+    }
+
+    void Reactor::open_connections(download* dl)
+    {
+        if (dl->finished) return;
+
+        const unsigned int unstarted = dl->chunks - dl->next + dl->retry.size();
+
+        while (dl->conns.size() < connections && dl->conns.size() < unstarted)
+        {
+            if (open >= max_connections)
+            {
+                if (!dl->starved)
+                    { dl->starved = true; starved.push_back(dl); }
+                return;
+            }
+
+            if (!open_connection(dl)) return;
+        }
+    }
+
+    bool Reactor::open_connection(download* dl)
+    {
+        sockaddr_in serv_addr;
+        if (!network::parse_address(dl->address.c_str(), &serv_addr))
+            { finish(dl, CONNECT_FAIL); return false; }
+
+        const int sock = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (sock < 0)
+            { if (dl->conns.empty()) finish(dl, SOCKET_FAIL); return false; }
+
+        network::tune_socket(sock);
+
+        connection* c = new connection;
+        c->socket = sock;
+        c->state  = connection::CONNECTING;
+        c->dl     = dl;
+        c->chunk  = -1;
+        c->sent   = 0;
+
+        dl->conns.push_back(c);
+        open++;
+
+        c->since = metrics::clock::now();
+        if (connect(sock, (sockaddr*)&serv_addr, sizeof(serv_addr)) < 0 && errno != EINPROGRESS)
+            { fail(c, CONNECT_FAIL); return false; }
+
+        watch(c, EPOLLOUT, true);
+        return true;
+    }
+
+    void Reactor::close_connection(connection* c)
+    {
+        epoll_ctl(poll_fd, EPOLL_CTL_DEL, c->socket, nullptr);
+        close(c->socket);
+        c->socket = -1;
+        open--;
+
+        std::vector<connection*>& conns = c->dl->conns;
+        conns.erase(std::find(conns.begin(), conns.end(), c));
+
+        // The event loop may still hold this connection in the current batch
+        closed.push_back(c);
+
+        // A socket has been freed up, give it to whichever file has been waiting the longest
+        while (!starved.empty() && open < max_connections)
+        {
+            download* dl = starved.front();
+            starved.pop_front();
+            dl->starved = false;
+            open_connections(dl);
+        }
+    }
+
+    void Reactor::on_writable(connection* c)
+    {
+        if (c->state == connection::CONNECTING)
+        {
+            int       error = 0;
+            socklen_t len   = sizeof(error);
+            getsockopt(c->socket, SOL_SOCKET, SO_ERROR, &error, &len);
+
+            if (error)
+                { metrics::add(metrics::CONNECT_FAILURES); fail(c, CONNECT_FAIL); return; }
+
+            metrics::record(metrics::CONNECT_TIME, c->since);
+            trace::record("connect", c->dl->filename.c_str(), -1, c->since);
+            metrics::add(metrics::CONNECTS);
+
+            c->since = metrics::clock::now();
+            c->state = connection::LOGIN;
+            c->out   = "LOGIN ADMIN ADMIN123";
+            c->sent  = 0;
+        }
+
+        send_pending(c);
+    }
+
+    void Reactor::send_pending(connection* c)
+    {
+        while (c->sent < c->out.size())
+        {
+            const int r = send(c->socket, c->out.c_str() + c->sent, c->out.size() - c->sent, MSG_NOSIGNAL);
+
+            if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                { watch(c, EPOLLOUT); return; }
+
+            if (r <= 0)
+                { fail(c, SOCKET_FAIL); return; }
+
+            c->sent += r;
+        }
+
+        metrics::add(metrics::BYTES_SENT, c->out.size());
+        metrics::add(metrics::COMMANDS);
+
+        c->state = (c->state == connection::LOGIN ? connection::AWAIT_LOGIN : connection::RECEIVING);
+        watch(c, EPOLLIN);
+    }
+
+    void Reactor::on_readable(connection* c)
+    {
+        if (c->state == connection::AWAIT_LOGIN)
+        {
+            char reply[16];
+            const int r = recv(c->socket, reply, sizeof(reply) - 1, 0);
+
+            if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+            if (r <= 0) { fail(c, SOCKET_FAIL); return; }
+
+            metrics::record(metrics::LOGIN_TIME, c->since);
+            trace::record("login", c->dl->filename.c_str(), -1, c->since);
+            metrics::add(metrics::BYTES_RECEIVED, r);
+
+            reply[r] = '\0';
+            if (std::strcmp(reply, "OK"))
+                { metrics::add(metrics::LOGIN_FAILURES); fail(c, LOGIN_FAIL); return; }
+
+            next_chunk(c);
+            return;
+        }
+
+        if (c->state != connection::RECEIVING) return;
+
+        char* buffer = c->dl->file->buffer + c->offset;
+
+        while (c->received < c->expected)
+        {
+            const int r = recv(c->socket, buffer + c->received, c->expected - c->received, 0);
+
+            if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+            if (r <= 0) { metrics::add(metrics::CHUNK_FAILURES); fail(c, SOCKET_FAIL); return; }
+
+            c->received += r;
+            metrics::add(metrics::BYTES_RECEIVED, r);
+        }
+
+        metrics::record(metrics::CHUNK_TIME, c->since);
+        trace::record("chunk", c->dl->filename.c_str(), c->chunk, c->since);
+        metrics::add(metrics::CHUNKS);
+
+        download* dl = c->dl;
+        c->chunk = -1;
+
+        if (--dl->remaining == 0)
+            { finish(dl, OK); return; }
+
+        next_chunk(c);
+    }
+
+    void Reactor::next_chunk(connection* c)
+    {
+        download* dl = c->dl;
+
+        if (!dl->retry.empty())
+        {
+            c->chunk = dl->retry.back();
+            dl->retry.pop_back();
+        }
+        else if (dl->next < dl->chunks)
+            c->chunk = dl->next++;
+        else
+            { close_connection(c); return; }
+
+        const unsigned int filesize = dl->file->filesize;
+
+        c->offset   = _FIN_BUFFER_SIZE * c->chunk;
+        c->expected = std::min<unsigned int>(_FIN_BUFFER_SIZE, filesize + 1 - c->offset);
+        c->received = 0;
+
+        c->since = metrics::clock::now();
+        c->state = connection::REQUEST;
+        c->out   = network::str_concat("REQ ", dl->filename.c_str(), " ", std::to_string(c->chunk).c_str());
+        c->sent  = 0;
+
+        send_pending(c);
+    }
+
+    void Reactor::fail(connection* c, const Status status)
+    {
+        download* dl = c->dl;
+
+        if (c->chunk >= 0)
+            dl->retry.push_back(c->chunk);
+
+        close_connection(c);
+        if (dl->finished) return;
+
+        // Bad credentials won't get any better by trying again
+        if (status == LOGIN_FAIL || ++dl->failures > connections * _FIN_CHUNK_RETRIES)
+            { finish(dl, status); return; }
+
+        open_connections(dl);
+    }
+
+    void Reactor::finish(download* dl, const Status status)
+    {
+        if (dl->finished) return;
+
+        // Detach the download first so closing its sockets doesn't try to reopen any
+        dl->finished = true;
+        downloads.erase(std::find(downloads.begin(), downloads.end(), dl));
+        if (dl->starved)
+            starved.erase(std::find(starved.begin(), starved.end(), dl));
+
+        while (!dl->conns.empty())
+            close_connection(dl->conns.back());
+
+        // A file whose query failed has no buffer and keeps the status of that failure
+        File* file = dl->file;
+        if (file->buffer)
+        {
+            file->status = status;
+            *(file->buffer + file->filesize) = '\0';
+        }
+
+        done.push_back(dl);
+    }
+
+    void Reactor::watch(connection* c, const unsigned int events, const bool add)
+    {
+        epoll_event ev;
+        ev.events   = events;
+        ev.data.ptr = c;
+        epoll_ctl(poll_fd, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, c->socket, &ev);
+    }
+
+    Reactor& reactor()
+    {
+        static Reactor instance;
+        return instance;
+    }
+}
+}
+
+#endif
@@ -0,0 +1,218 @@
+#include "finapi/finapi.h"
+
+namespace finapi
+{
+    // Pool and queue index of the worker running on this thread, if any
+    static thread_local ThreadPool*  current_pool  = nullptr;
+    static thread_local unsigned int current_index = 0;
+
+    /**
+     * @brief Amount of threads a pool of the given size gets, zero picks the hardware concurrency.
+     */
+    static unsigned int worker_count(c_uint count)
+    {
+        unsigned int amount = count;
+        if (!amount) amount = std::thread::hardware_concurrency();
+        if (!amount) amount = 1;
+        return amount;
+    }
+
+    /*          TaskGroup           */
+    TaskGroup::TaskGroup() :
+        remaining(0)
+    {   }
+
+    void TaskGroup::add(c_uint count)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        remaining += count;
+    }
+
+    void TaskGroup::done()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--remaining == 0) finished.notify_all();
+    }
+
+    void TaskGroup::wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this]() { return remaining == 0; });
+    }
+
+    /*          ThreadPool          */
+    ThreadPool::ThreadPool(c_uint workers) :
+        pending(0), next(0), stopping(false)
+    {
+        start(workers);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        std::lock_guard<std::mutex> lock(resizing);
+        stop();
+
+        // Tasks no worker got to are run here instead of dropped, somebody may be waiting on
+        // them. This thread stands in for the workers, so what they submit is run inline
+        ThreadPool* outer = current_pool;
+        current_pool = this;
+
+        task t;
+        while (pop(0, t))
+        {
+            t();
+            t = nullptr;
+        }
+
+        current_pool = outer;
+
+        for (queue* q : queues)
+            delete q;
+    }
+
+    void ThreadPool::submit(task t, TaskGroup* group)
+    {
+        if (group)
+        {
+            group->add();
+            t = [t, group]() { t(); group->done(); };
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(control);
+
+            if (stopping && current_pool == this)
+                { lock.unlock(); t(); return; }
+
+            const unsigned int index = (current_pool == this ?
+                current_index : next++ % queues.size());
+
+            std::lock_guard<std::mutex> q_lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(std::move(t));
+            pending++;
+        }
+
+        std::lock_guard<std::mutex> lock(sleep);
+        wake.notify_one();
+    }
+
+    void ThreadPool::resize(c_uint workers)
+    {
+        std::lock_guard<std::mutex> resize_lock(resizing);
+        stop();
+
+        std::lock_guard<std::mutex> lock(control);
+
+        // Collect whatever hasn't been run yet so it can be dealt out to the new queues
+        std::deque<task> leftover;
+        for (queue* q : queues)
+        {
+            for (task& t : q->tasks)
+                leftover.push_back(std::move(t));
+            delete q;
+        }
+        queues.clear();
+
+        // Dealt out before the new workers start, so nobody else touches the queues yet
+        const unsigned int amount = worker_count(workers);
+        for (unsigned int i = 0; i < amount; i++)
+            queues.push_back(new queue);
+
+        for (unsigned int i = 0; i < leftover.size(); i++)
+            queues[i % amount]->tasks.push_back(std::move(leftover[i]));
+
+        start(workers);
+    }
+
+    unsigned int ThreadPool::size()
+    {
+        std::lock_guard<std::mutex> lock(control);
+        return workers.size();
+    }
+
+    void ThreadPool::start(c_uint count)
+    {
+        const unsigned int amount = worker_count(count);
+
+        {
+            std::lock_guard<std::mutex> lock(sleep);
+            stopping = false;
+        }
+
+        if (queues.empty())
+            for (unsigned int i = 0; i < amount; i++)
+                queues.push_back(new queue);
+
+        for (unsigned int i = 0; i < amount; i++)
+            workers.emplace_back(&ThreadPool::work, this, i);
+    }
+
+    void ThreadPool::stop()
+    {
+        std::vector<std::thread> retiring;
+        {
+            std::lock_guard<std::mutex> lock(control);
+            std::lock_guard<std::mutex> s_lock(sleep);
+
+            stopping = true;
+            retiring.swap(workers);
+        }
+        wake.notify_all();
+
+        for (std::thread& t : retiring)
+            t.join();
+    }
+
+    void ThreadPool::work(c_uint index)
+    {
+        current_pool  = this;
+        current_index = index;
+
+        task t;
+        for (;;)
+        {
+            if (pop(index, t))
+            {
+                t();
+                t = nullptr;
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep);
+            wake.wait(lock, [this]() { return stopping || pending > 0; });
+            if (stopping) return;
+        }
+    }
+
+    bool ThreadPool::pop(c_uint index, task& t)
+    {
+        // Own queue first, oldest task first
+        {
+            queue* q = queues[index];
+            std::lock_guard<std::mutex> lock(q->mutex);
+            if (!q->tasks.empty())
+            {
+                t = std::move(q->tasks.front());
+                q->tasks.pop_front();
+                pending--;
+                return true;
+            }
+        }
+
+        // Then steal the newest task of someone else
+        for (unsigned int i = 1; i < queues.size(); i++)
+        {
+            queue* q = queues[(index + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(q->mutex);
+            if (!q->tasks.empty())
+            {
+                t = std::move(q->tasks.back());
+                q->tasks.pop_back();
+                pending--;
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
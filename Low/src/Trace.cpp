@@ -0,0 +1,219 @@
+#include "finapi/finapi.h"
+
+#include <cstdio>
+
+namespace finapi
+{
+namespace trace
+{
+    /**
+     * @brief Slot of the ring, its sequence tells which span it holds and whether it's done.
+     *
+     * Span n is being written while the sequence is 2n + 1 and is complete at 2n + 2.
+     */
+    struct slot
+    {
+        std::atomic<unsigned long long> sequence;
+        span                            data;
+    };
+
+    std::atomic<bool> active(false);
+
+    static std::atomic<slot*>              ring(nullptr);
+    static std::atomic<unsigned long long> head(0);
+    static clock::time_point               epoch;
+    static std::mutex                      setup;
+
+    // Tags the scopes of this thread hand on to the spans inside them
+    static thread_local const char* current_file  = nullptr;
+    static thread_local int         current_chunk = -1;
+
+    static unsigned int thread_ordinal()
+    {
+        static std::atomic<unsigned int> next(1);
+        static thread_local const unsigned int ordinal = next.fetch_add(1, std::memory_order_relaxed);
+        return ordinal;
+    }
+
+    void start()
+    {
+        std::lock_guard<std::mutex> lock(setup);
+
+        if (!ring.load(std::memory_order_relaxed))
+        {
+            slot* slots = new slot[_FIN_TRACE_CAPACITY];
+            for (unsigned int i = 0; i < _FIN_TRACE_CAPACITY; i++)
+                slots[i].sequence.store(0, std::memory_order_relaxed);
+
+            epoch = clock::now();
+            ring.store(slots, std::memory_order_release);
+        }
+
+        active.store(true, std::memory_order_release);
+    }
+
+    void stop()
+    {
+        active.store(false, std::memory_order_release);
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(setup);
+
+        slot* slots = ring.load(std::memory_order_acquire);
+        if (!slots) return;
+
+        for (unsigned int i = 0; i < _FIN_TRACE_CAPACITY; i++)
+            slots[i].sequence.store(0, std::memory_order_relaxed);
+
+        head.store(0, std::memory_order_release);
+    }
+
+    void record(const char* name, const char* file, const int chunk, const clock::time_point begin)
+    {
+        slot* slots = ring.load(std::memory_order_acquire);
+        if (!slots || !enabled()) return;
+
+        const clock::time_point end = clock::now();
+
+        const unsigned long long n = head.fetch_add(1, std::memory_order_relaxed);
+        slot& s = slots[n % _FIN_TRACE_CAPACITY];
+
+        s.sequence.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        if (!file) file = current_file;
+
+        s.data.name     = name;
+        s.data.chunk    = (chunk >= 0 ? chunk : current_chunk);
+        s.data.thread   = thread_ordinal();
+        s.data.start    = std::chrono::duration_cast<std::chrono::nanoseconds>(begin - epoch).count();
+        s.data.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+
+        if (file)
+        {
+            std::strncpy(s.data.file, file, _FIN_TRACE_FILENAME - 1);
+            s.data.file[_FIN_TRACE_FILENAME - 1] = '\0';
+        }
+        else
+            s.data.file[0] = '\0';
+
+        s.sequence.store(2 * n + 2, std::memory_order_release);
+    }
+
+    void scope::open(const char* file, const int chunk)
+    {
+        outer_file  = current_file;
+        outer_chunk = current_chunk;
+
+        if (file)       current_file  = file;
+        if (chunk >= 0) current_chunk = chunk;
+
+        begin = clock::now();
+    }
+
+    void scope::close()
+    {
+        record(name, nullptr, -1, begin);
+
+        current_file  = outer_file;
+        current_chunk = outer_chunk;
+    }
+
+    std::vector<span> spans()
+    {
+        std::vector<span> r;
+
+        slot* slots = ring.load(std::memory_order_acquire);
+        if (!slots) return r;
+
+        const unsigned long long last  = head.load(std::memory_order_acquire);
+        const unsigned long long first = (last > _FIN_TRACE_CAPACITY ? last - _FIN_TRACE_CAPACITY : 0);
+        r.reserve(last - first);
+
+        for (unsigned long long n = first; n < last; n++)
+        {
+            const slot& s = slots[n % _FIN_TRACE_CAPACITY];
+
+            // Only a span that is complete, and still the same one after copying it, is kept
+            if (s.sequence.load(std::memory_order_acquire) != 2 * n + 2) continue;
+
+            span copy = s.data;
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (s.sequence.load(std::memory_order_relaxed) == 2 * n + 2)
+                r.push_back(copy);
+        }
+
+        return r;
+    }
+
+    static void append_escaped(std::string& out, const char* str)
+    {
+        for (; *str; str++)
+        {
+            const unsigned char c = *str;
+            if (c == '"' || c == '\\')
+                { out += '\\'; out += c; }
+            else if (c < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            }
+            else
+                out += c;
+        }
+    }
+
+    std::string chrome_json()
+    {
+        const std::vector<span> recorded = spans();
+
+        std::string r = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        char number[128];
+
+        for (std::size_t i = 0; i < recorded.size(); i++)
+        {
+            const span& s = recorded[i];
+
+            r += (i ? ",\n" : "\n");
+            r += "{\"name\":\"";
+            append_escaped(r, s.name);
+
+            std::snprintf(number, sizeof(number), "\",\"cat\":\"finapi\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{",
+                          s.thread, s.start / 1000.0, s.duration / 1000.0);
+            r += number;
+
+            if (s.file[0])
+            {
+                r += "\"file\":\"";
+                append_escaped(r, s.file);
+                r += (s.chunk >= 0 ? "\"," : "\"");
+            }
+
+            if (s.chunk >= 0)
+            {
+                std::snprintf(number, sizeof(number), "\"chunk\":%d", s.chunk);
+                r += number;
+            }
+
+            r += "}}";
+        }
+
+        r += "\n]}\n";
+        return r;
+    }
+
+    bool write_chrome(const char* path)
+    {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) return false;
+
+        const std::string json = chrome_json();
+        out.write(json.data(), json.size());
+        return (bool)out;
+    }
+}
+}
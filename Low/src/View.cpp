@@ -0,0 +1,294 @@
+#include "finapi/finapi.h"
+
+namespace finapi
+{
+    /**
+     * @brief Reads a value at the cursor and moves past it.
+     */
+    template<typename T>
+    static T take(const char*& cursor)
+    {
+        const T r = endian::load<T>(cursor);
+        cursor += sizeof(T);
+        return r;
+    }
+
+    /**
+     * @brief Points a view at the length prefixed string at the cursor and moves past it.
+     */
+    static std::string_view take_string(const char*& cursor)
+    {
+        const unsigned int size = take<unsigned int>(cursor);
+        std::string_view r(cursor, size);
+        cursor += size;
+        return r;
+    }
+
+    /**
+     * @brief Checks the magic number of a buffer and returns the first byte after it.
+     */
+    static const char* header(const char* data, c_uint size, c_uint magic_number, bool& magic)
+    {
+        magic = (data && size >= 2 * sizeof(unsigned int));
+        if (!magic) return data;
+
+        const char* cursor = data;
+        magic = (MAGIC_NUMBER(take<unsigned int>(cursor)) == magic_number);
+        return cursor;
+    }
+
+    /*          DataTagView          */
+    DataTagView::DataTagView(const char* record, const char* end) :
+        record(record), end(end), decoded(false), sequence_(0), value_(0)
+    {   }
+
+    int DataTagView::sequence() const
+    {
+        decode();
+        return sequence_;
+    }
+
+    float DataTagView::value() const
+    {
+        decode();
+        return value_;
+    }
+
+    const char* DataTagView::skip(const char* record, const char* end)
+    {
+        return (record ? schema::extent<DataTag>(record, end) : nullptr);
+    }
+
+    std::string_view DataTagView::string(c_uint index) const
+    {
+        decode();
+        return strings[index];
+    }
+
+    void DataTagView::decode() const
+    {
+        if (decoded) return;
+        decoded = true;
+
+        // A record that runs past the buffer keeps its fields empty, the rest reads unchecked
+        if (!skip(record, end)) return;
+
+        const char* cursor = record;
+        schema::visit<DataTag>([this, &cursor](auto field)
+        {
+            typedef decltype(field) F;
+
+            if constexpr (F::type == schema::INT)
+                sequence_ = take<int>(cursor);
+            else if constexpr (F::type == schema::FLOAT)
+                value_ = take<float>(cursor);
+            else
+            {
+                cursor += sizeof(unsigned int);
+                strings[F::index] = take_string(cursor);
+            }
+        });
+    }
+
+    /*        DataTagListView        */
+    DataTagListView::DataTagListView(const Cloud::File* file) :
+        DataTagListView(file ? file->buffer : nullptr, file ? file->filesize : 0)
+    {   }
+
+    DataTagListView::DataTagListView(const char* data, c_uint size) :
+        data(data), first(nullptr), count(0), limit(data + size), table(nullptr), index(nullptr)
+    {
+        first = header(data, size, DATA_TAG_MN, magic);
+        if (!magic) return;
+
+        const char* cursor = data;
+        const unsigned int mn = take<unsigned int>(cursor);
+        const unsigned int version = MAGIC_VERSION(mn);
+
+        count = take<unsigned int>(first);
+
+        if (version < 2) return;
+
+        // A v2 header that doesn't fit the buffer makes the whole file unusable
+        magic = (size >= sizeof(format::tag_header) + count * sizeof(unsigned int));
+        if (!magic) { count = 0; return; }
+
+        const unsigned int flags = take<unsigned int>(first);
+        const unsigned int at    = take<unsigned int>(first);
+
+        table  = first;
+        first += count * sizeof(unsigned int);
+
+        if ((flags & format::TAG_INDEX) && at && at + count * sizeof(unsigned int) <= size)
+            index = data + at;
+    }
+
+    bool DataTagListView::valid() const
+    {
+        return magic;
+    }
+
+    unsigned int DataTagListView::size() const
+    {
+        return count;
+    }
+
+    DataTagView DataTagListView::operator[](c_uint index) const
+    {
+        if (index >= count) return DataTagView();
+
+        if (table)
+        {
+            // Records sit between the offset table and the end of the buffer
+            const char* entry = table + index * sizeof(unsigned int);
+            const unsigned int offset = take<unsigned int>(entry);
+
+            if (offset < (std::size_t)(first - data) || offset >= (std::size_t)(limit - data))
+                return DataTagView();
+
+            return DataTagView(data + offset, limit);
+        }
+
+        // Only the whole records get an entry, a count the buffer can't hold isn't reserved
+        if (offsets.empty() && count)
+        {
+            offsets.reserve(std::min<std::size_t>(count, (limit - first) / schema::min_size<DataTag>()));
+
+            const char* record = first;
+            for (unsigned int i = 0; i < count; i++)
+            {
+                const char* next = DataTagView::skip(record, limit);
+                if (!next) break;
+
+                offsets.push_back(record);
+                record = next;
+            }
+        }
+
+        return (index < offsets.size() ? DataTagView(offsets[index], limit) : DataTagView());
+    }
+
+    unsigned int DataTagListView::find(std::string_view tag) const
+    {
+        if (!index)
+        {
+            unsigned int i = 0;
+            for (const DataTagView record : *this)
+            {
+                if (record.tag() == tag) return i;
+                i++;
+            }
+
+            return count;
+        }
+
+        // Lower bound over the record numbers, ordered by their tags
+        unsigned int low = 0, high = count;
+        while (low < high)
+        {
+            const unsigned int middle = low + (high - low) / 2;
+            const char* entry = index + middle * sizeof(unsigned int);
+
+            if ((*this)[take<unsigned int>(entry)].tag() < tag)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+
+        if (low == count) return count;
+
+        const char* entry = index + low * sizeof(unsigned int);
+        const unsigned int record = take<unsigned int>(entry);
+        return ((*this)[record].tag() == tag ? record : count);
+    }
+
+    /*         StatementView         */
+    StatementView::StatementView(const Cloud::File* file) :
+        StatementView(file ? file->buffer : nullptr, file ? file->filesize : 0)
+    {   }
+
+    StatementView::StatementView(const char* data, c_uint size) :
+        end(data + size), decoded(false), fiscal_year_(0)
+    {
+        this->data = header(data, size, STATEMENT_MN, magic);
+    }
+
+    bool StatementView::valid() const
+    {
+        return magic;
+    }
+
+    int StatementView::fiscal_year() const
+    {
+        decode();
+        return fiscal_year_;
+    }
+
+    std::string_view StatementView::string(c_uint index) const
+    {
+        decode();
+        return strings[index];
+    }
+
+    void StatementView::decode() const
+    {
+        if (decoded || !magic) return;
+
+        const char* cursor = data;
+
+        // Anything but the layout of the schema, or a record cut off, leaves the fields empty
+        if (take<unsigned int>(cursor) == schema::model<Statement>::layout::count && schema::extent<Statement>(cursor, end))
+        {
+            schema::visit<Statement>([this, &cursor](auto field)
+            {
+                typedef decltype(field) F;
+
+                if constexpr (F::string)
+                    strings[F::index] = take_string(cursor);
+                else
+                    fiscal_year_ = take<int>(cursor);
+            });
+        }
+
+        decoded = true;
+    }
+
+    /*          CompanyView          */
+    CompanyView::CompanyView(const Cloud::File* file) :
+        CompanyView(file ? file->buffer : nullptr, file ? file->filesize : 0)
+    {   }
+
+    CompanyView::CompanyView(const char* data, c_uint size) :
+        end(data + size), decoded(false)
+    {
+        this->data = header(data, size, COMPANY_MN, magic);
+    }
+
+    bool CompanyView::valid() const
+    {
+        return magic;
+    }
+
+    std::string_view CompanyView::string(c_uint index) const
+    {
+        decode();
+        return strings[index];
+    }
+
+    void CompanyView::decode() const
+    {
+        if (decoded || !magic) return;
+
+        const char* cursor = data;
+
+        if (take<unsigned int>(cursor) == schema::model<Company>::layout::count && schema::extent<Company>(cursor, end))
+        {
+            schema::visit<Company>([this, &cursor](auto field)
+            {
+                strings[decltype(field)::index] = take_string(cursor);
+            });
+        }
+
+        decoded = true;
+    }
+}
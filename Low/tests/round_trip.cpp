@@ -0,0 +1,248 @@
+/**
+ * @file round_trip.cpp
+ *
+ * @brief Checks that every model reads back as what was written, run by CTest.
+ *
+ * DataTag lists are written in both layouts, read back through a byte source, a
+ * Cloud::File and a stream, and written again, which has to give the same bytes. The v2
+ * output also has to match what upgrade_tags makes of the v1 file. A Company and a
+ * Statement go through the same round trip. Every failed check is printed and makes the
+ * test exit with 1.
+ *
+ * @author  Max Ortner
+ * @date    2020-02-01
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#include "finapi/finapi.h"
+
+#include <iostream>
+
+using namespace finapi;
+
+namespace round_trip
+{
+    static unsigned int failures = 0;
+
+    static void check(const bool condition, const std::string& what)
+    {
+        if (condition) return;
+
+        std::cerr << "FAILED: " << what << "\n";
+        failures++;
+    }
+
+    static bool same_bytes(const ByteSink& a, const char* data, const std::size_t size)
+    {
+        return (a.size() == size && !std::memcmp(a.data(), data, size));
+    }
+
+    static bool same_string(const char* a, const char* b)
+    {
+        return (a && b && !std::strcmp(a, b));
+    }
+
+    static std::vector<DataTag*> make_tags(c_uint count)
+    {
+        static const char* units[] = { "USD", "shares", "pure" };
+
+        std::vector<DataTag*> r;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            DataTag* tag  = new DataTag;
+            tag->balance  = strdup(i % 2 ? "credit" : "debit");
+            tag->factor   = strdup("1");
+            tag->id       = strdup(("tag-" + std::to_string(i)).c_str());
+            tag->name     = strdup(("Name of tag " + std::to_string(i * 7)).c_str());
+            tag->parent   = strdup(i % 5 ? "Assets" : "");
+            tag->tag      = strdup(("Tag" + std::to_string(i % 50)).c_str());
+            tag->unit     = strdup(units[i % 3]);
+            tag->sequence = i;
+            tag->value    = i * 0.25f;
+            r.push_back(tag);
+        }
+
+        return r;
+    }
+
+    static bool same_tags(const std::vector<DataTag*>& a, const std::vector<DataTag*>& b)
+    {
+        if (a.size() != b.size()) return false;
+
+        for (std::size_t i = 0; i < a.size(); i++)
+        {
+            if (!same_string(a[i]->balance, b[i]->balance) || !same_string(a[i]->factor, b[i]->factor) ||
+                !same_string(a[i]->id, b[i]->id) || !same_string(a[i]->name, b[i]->name) ||
+                !same_string(a[i]->parent, b[i]->parent) || !same_string(a[i]->tag, b[i]->tag) ||
+                !same_string(a[i]->unit, b[i]->unit) || a[i]->sequence != b[i]->sequence || a[i]->value != b[i]->value)
+                return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Writes the tags in one layout and reads them back through every kind of source.
+     */
+    static void tags(const std::vector<DataTag*>& written, c_uint version)
+    {
+        const std::string layout = "v" + std::to_string(version) + " tags: ";
+
+        ByteSink first;
+        serialize(written, first, version);
+
+        // Byte source
+        {
+            std::vector<DataTag*> read;
+            ByteSource source(first.data(), first.size());
+            deserialize(read, source);
+
+            check(!source.truncated, layout + "byte source reported a short file");
+            check(same_tags(written, read), layout + "byte source read back different tags");
+
+            ByteSink second;
+            serialize(read, second, version);
+            check(same_bytes(second, first.data(), first.size()), layout + "writing them again gave different bytes");
+
+            clean_list(read);
+        }
+
+        // Cloud::File
+        {
+            Cloud::File* file = new Cloud::File((unsigned int)first.size());
+            std::memcpy(file->buffer, first.data(), first.size());
+
+            std::vector<DataTag*> read;
+            deserialize(read, file);
+
+            check(file->status == Cloud::OK, layout + "Cloud::File reported a short file");
+            check(same_tags(written, read), layout + "Cloud::File read back different tags");
+
+            clean_list(read);
+            delete file;
+        }
+
+        // Stream
+        {
+            const std::string path = (std::filesystem::temp_directory_path() / ("finapi_round_trip_v" + std::to_string(version) + ".bin")).string();
+            {
+                std::ofstream out(path, std::ios::binary);
+                out.write(first.data(), first.size());
+            }
+
+            std::vector<DataTag*> read;
+            {
+                std::ifstream in(path, std::ios::binary);
+                deserialize(read, in);
+            }
+
+            check(same_tags(written, read), layout + "stream read back different tags");
+
+            clean_list(read);
+            std::filesystem::remove(path);
+        }
+
+        // The view has to see the same records
+        {
+            const DataTagListView view(first.data(), first.size());
+            check(view.valid() && view.size() == written.size(), layout + "view saw a different record count");
+
+            bool same = true;
+            for (unsigned int i = 0; i < view.size() && i < written.size(); i++)
+                same = same && view[i].id() == written[i]->id && view[i].sequence() == written[i]->sequence;
+
+            check(same, layout + "view read back different records");
+        }
+    }
+
+    /**
+     * @brief The v2 writer and upgrade_tags have to agree on the layout.
+     */
+    static void upgrade(const std::vector<DataTag*>& written)
+    {
+        ByteSink v1, v2;
+        serialize(written, v1);
+        serialize(written, v2, 2);
+
+        std::vector<char> upgraded;
+        check(format::upgrade_tags(v1.data(), v1.size(), upgraded), "upgrade_tags turned down a whole v1 file");
+        check(same_bytes(v2, upgraded.data(), upgraded.size()), "upgrade_tags and the v2 writer gave different bytes");
+    }
+
+    static void models()
+    {
+        Company company;
+        company.cik    = strdup("0000320193");
+        company.id     = strdup("company-1");
+        company.lei    = strdup("HWUPKR0MPOU8FGXBT394");
+        company.name   = strdup("Apple Inc.");
+        company.ticker = strdup("AAPL");
+
+        Statement statement;
+        statement.end_date       = strdup("2019-09-28");
+        statement.filing_date    = strdup("2019-10-31");
+        statement.fiscal_period  = strdup("FY");
+        statement.fiscal_year    = 2019;
+        statement.id             = strdup("statement-1");
+        statement.start_date     = strdup("2018-09-30");
+        statement.statement_code = strdup("BS");
+        statement.type           = strdup("10-K");
+
+        ByteSink first, second;
+        serialize(&company, first);
+        serialize(&statement, first);
+
+        ByteSource source(first.data(), first.size());
+        Company*   company_read   = nullptr;
+        Statement* statement_read = nullptr;
+        deserialize(&company_read, source);
+        deserialize(&statement_read, source);
+
+        check(company_read && same_string(company_read->name, company.name) && same_string(company_read->ticker, company.ticker) &&
+              same_string(company_read->cik, company.cik) && same_string(company_read->lei, company.lei),
+              "Company read back different");
+
+        check(statement_read && same_string(statement_read->id, statement.id) && statement_read->fiscal_year == statement.fiscal_year &&
+              same_string(statement_read->end_date, statement.end_date) && same_string(statement_read->type, statement.type),
+              "Statement read back different");
+
+        if (company_read && statement_read)
+        {
+            serialize(company_read, second);
+            serialize(statement_read, second);
+            check(same_bytes(second, first.data(), first.size()), "writing the Company and Statement again gave different bytes");
+        }
+
+        delete company_read;
+        delete statement_read;
+    }
+}
+
+int main()
+{
+    std::vector<DataTag*> tags = round_trip::make_tags(1000);
+
+    round_trip::tags(tags, 1);
+    round_trip::tags(tags, 2);
+    round_trip::upgrade(tags);
+    round_trip::models();
+
+    // Nothing to read is still a file
+    std::vector<DataTag*> none;
+    round_trip::tags(none, 1);
+    round_trip::tags(none, 2);
+
+    clean_list(tags);
+
+    if (round_trip::failures)
+    {
+        std::cerr << round_trip::failures << " round trip checks failed\n";
+        return 1;
+    }
+
+    std::cout << "every round trip came back the same\n";
+    return 0;
+}
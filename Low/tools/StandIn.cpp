@@ -0,0 +1,296 @@
+#include "StandIn.h"
+
+#include <sstream>
+
+#include <poll.h>
+#include <fcntl.h>
+
+namespace tools
+{
+    using namespace finapi;
+
+    // Size of a chunk, typed for the std::min calls below
+    static const std::size_t CHUNK = _FIN_BUFFER_SIZE;
+
+    // Largest piece handed to send() at once on a paced connection
+    static const std::size_t PACING_SLICE = 16 * 1024;
+
+    StandIn::StandIn() :
+        StandIn(settings())
+    {   }
+
+    StandIn::StandIn(const settings& config) :
+        config(config), listener(-1), bound_port(0), running(false), rng(config.seed),
+        connections(0), requests(0), chunks(0), bytes(0), dropped(0)
+    {   }
+
+    StandIn::~StandIn()
+    {
+        stop();
+    }
+
+    void StandIn::add_file(const std::string& name, const std::string& data)
+    {
+        file& f = files[name];
+        f.data = data;
+        f.data.push_back('\0');
+        f.blocks.clear();
+    }
+
+    bool StandIn::start()
+    {
+        if (running) return true;
+
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        if (listener < 0) return false;
+
+        const int on = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        sockaddr_in local;
+        std::memset(&local, 0, sizeof(local));
+        local.sin_family      = AF_INET;
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        local.sin_port        = htons(config.port);
+
+        socklen_t length = sizeof(local);
+        if (bind(listener, (sockaddr*)&local, sizeof(local)) != 0 ||
+            listen(listener, 512) != 0 ||
+            getsockname(listener, (sockaddr*)&local, &length) != 0)
+        {
+            close(listener);
+            listener = -1;
+            return false;
+        }
+
+        bound_port = ntohs(local.sin_port);
+        running    = true;
+        thread     = std::thread(&StandIn::run, this);
+        return true;
+    }
+
+    void StandIn::stop()
+    {
+        if (!running) return;
+
+        running = false;
+        thread.join();
+
+        close(listener);
+        listener = -1;
+    }
+
+    std::string StandIn::address() const
+    {
+        return "127.0.0.1:" + std::to_string(bound_port);
+    }
+
+    StandIn::stats StandIn::statistics() const
+    {
+        return { connections.load(), requests.load(), chunks.load(), bytes.load(), dropped.load() };
+    }
+
+    /**
+     * @brief Whether a client still has a reply to send, or a lost one to hang up on.
+     */
+    bool StandIn::pending(const client& c)
+    {
+        return (c.sent < c.out.size() || c.close_after);
+    }
+
+    void StandIn::run()
+    {
+        std::vector<client> clients;
+        std::vector<pollfd> fds;
+        char buffer[4096];
+
+        while (running)
+        {
+            const clock::time_point now = clock::now();
+
+            // Sleep until the next held back reply is due, waking up regularly to notice stop()
+            int timeout = 50;
+
+            fds.clear();
+            fds.push_back({ listener, POLLIN, 0 });
+
+            for (client& c : clients)
+            {
+                short events = POLLIN;
+                if (pending(c))
+                {
+                    if (c.ready <= now)
+                        events |= POLLOUT;
+                    else
+                        timeout = std::min<int>(timeout, std::chrono::duration_cast<std::chrono::milliseconds>(c.ready - now).count() + 1);
+                }
+
+                fds.push_back({ c.socket, events, 0 });
+            }
+
+            if (poll(fds.data(), fds.size(), timeout) < 0 && errno != EINTR) break;
+
+            const clock::time_point later = clock::now();
+
+            // Every client is looked at, a paced one may be due without any event
+            std::vector<bool> closed(clients.size(), false);
+            for (std::size_t i = 0; i < clients.size(); i++)
+            {
+                client& c = clients[i];
+                const short revents = fds[i + 1].revents;
+
+                if (revents & (POLLERR | POLLNVAL))
+                    { closed[i] = true; continue; }
+
+                if (revents & (POLLIN | POLLHUP))
+                {
+                    const int received = recv(c.socket, buffer, sizeof(buffer), 0);
+                    if (received <= 0)
+                        { closed[i] = true; continue; }
+
+                    // The client waits for every reply before sending its next command,
+                    // so one read holds one command
+                    handle(c, std::string(buffer, received));
+                }
+
+                if (pending(c) && c.ready <= later && !flush(c, later))
+                    closed[i] = true;
+            }
+
+            for (std::size_t i = clients.size(); i-- > 0;)
+            {
+                if (!closed[i]) continue;
+
+                close(clients[i].socket);
+                clients.erase(clients.begin() + i);
+            }
+
+            if (fds[0].revents & POLLIN)
+            {
+                const int sock = accept(listener, nullptr, nullptr);
+                if (sock >= 0)
+                {
+                    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+                    client c;
+                    c.socket = sock;
+                    c.ready  = later;
+                    clients.push_back(c);
+                    connections++;
+                }
+            }
+        }
+
+        for (const client& c : clients)
+            close(c.socket);
+    }
+
+    void StandIn::handle(client& c, const std::string& command)
+    {
+        std::istringstream in(command);
+        std::string verb, name;
+        in >> verb >> name;
+
+        std::string reply;
+        auto u32 = [&reply](c_uint value)
+        {
+            const unsigned int stored = endian::little(value);
+            reply.append((const char*)&stored, sizeof(stored));
+        };
+
+        auto found = files.find(name);
+
+        if (verb == "exists")
+            reply = (found != files.end() ? "T" : "F");
+        else if (verb == "LOGIN")
+        {
+            std::string password;
+            in >> password;
+            reply = (name == "ADMIN" && password == "ADMIN123" ? "OK" : "FAIL");
+        }
+        else if (verb == "COMPRESS")
+        {
+            c.compressed = config.compress;
+            reply = (config.compress ? "OK" : "ERR");
+        }
+        else if (verb == "SZE")
+            u32(found != files.end() ? found->second.data.size() : 0);
+        else if (verb == "CHK")
+            u32(found != files.end() ? (found->second.data.size() + CHUNK - 1) / CHUNK : 0);
+        else if (verb == "REQ" && found != files.end())
+        {
+            const std::string& data = found->second.data;
+            const unsigned int total = (data.size() + CHUNK - 1) / CHUNK;
+
+            unsigned int first = 0, count = 1;
+            in >> first;
+            if (!(in >> count)) count = 1;
+
+            first = std::min(first, total);
+            count = std::min(count, total - first);
+
+            if (c.compressed)
+            {
+                const std::vector<std::string>& packed = blocks(found->second);
+                for (unsigned int i = first; i < first + count; i++)
+                    reply += packed[i];
+            }
+            else if (count)
+                reply.assign(data, first * CHUNK, count * CHUNK);
+
+            requests++;
+            chunks += count;
+
+            // A lost reply stops somewhere in the middle and takes the connection with it
+            if (config.loss > 0 && !reply.empty() && std::uniform_real_distribution<double>(0, 1)(rng) < config.loss)
+            {
+                reply.resize(std::uniform_int_distribution<std::size_t>(0, reply.size() - 1)(rng));
+                c.close_after = true;
+                dropped++;
+            }
+        }
+        else
+            reply = "ERR";
+
+        c.out   = reply;
+        c.sent  = 0;
+        c.ready = clock::now() + std::chrono::microseconds(config.latency_us);
+    }
+
+    bool StandIn::flush(client& c, const clock::time_point now)
+    {
+        std::size_t length = c.out.size() - c.sent;
+        if (config.bandwidth)
+            length = std::min(length, PACING_SLICE);
+
+        if (length)
+        {
+            const int r = send(c.socket, c.out.data() + c.sent, length, _FIN_SEND_FLAGS);
+            if (r < 0)
+                return (errno == EAGAIN || errno == EWOULDBLOCK);
+
+            c.sent += r;
+            bytes  += r;
+
+            // The next slice goes out once this one has taken its time on the wire
+            if (config.bandwidth)
+                c.ready = now + std::chrono::microseconds(r * 1000000ull / config.bandwidth);
+        }
+
+        return !(c.close_after && c.sent == c.out.size());
+    }
+
+    const std::vector<std::string>& StandIn::blocks(file& f)
+    {
+        if (!f.blocks.empty() || f.data.empty()) return f.blocks;
+
+        char block[_FIN_BLOCK_BOUND(_FIN_BUFFER_SIZE)];
+        for (std::size_t offset = 0; offset < f.data.size(); offset += CHUNK)
+        {
+            const unsigned int raw = std::min<std::size_t>(CHUNK, f.data.size() - offset);
+            f.blocks.emplace_back(block, compress::write_block(f.data.data() + offset, raw, block));
+        }
+
+        return f.blocks;
+    }
+}
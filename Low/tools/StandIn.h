@@ -0,0 +1,154 @@
+/**
+ * @file StandIn.h
+ *
+ * @brief Loopback stand-in for the file server, for measuring the client without the real one.
+ *
+ * The stand-in speaks the same text protocol as the production server (exists, LOGIN, SZE,
+ * CHK, single and ranged REQ, COMPRESS) and serves files held in memory. It runs on a single
+ * thread polling every connection, so it adds exactly one thread to whatever is measured.
+ *
+ * Slow or unreliable networks are imitated on top of that: every reply can be held back by a
+ * fixed latency, each connection can be paced to a bandwidth, and a share of the chunk
+ * replies can be cut off part way with the connection dropped, which is what a lost segment
+ * looks like to the client once TCP gives up.
+ *
+ * POSIX only.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-28
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#pragma once
+
+#include "finapi/finapi.h"
+
+#include <random>
+
+namespace tools
+{
+    class StandIn
+    {
+    public:
+        struct settings
+        {
+            // Port to listen on, zero picks a free one
+            unsigned int       port       = 0;
+
+            // Microseconds every reply is held back
+            unsigned int       latency_us = 0;
+
+            // Bytes per second sent on each connection, zero for no limit
+            unsigned long long bandwidth  = 0;
+
+            // Chance that a chunk reply is cut off and its connection dropped
+            double             loss       = 0;
+
+            // Whether COMPRESS is agreed to
+            bool               compress   = true;
+
+            unsigned int       seed       = 1;
+        };
+
+        struct stats
+        {
+            unsigned long long connections;
+            unsigned long long requests;
+            unsigned long long chunks;
+            unsigned long long bytes;
+            unsigned long long dropped;
+        };
+
+        StandIn();
+        StandIn(const settings& config);
+        ~StandIn();
+
+        StandIn(const StandIn&) = delete;
+        StandIn& operator=(const StandIn&) = delete;
+
+        /**
+         * @brief Serves a file under a name, files have to be added before start().
+         */
+        void add_file(const std::string& name, const std::string& data);
+
+        /**
+         * @brief Starts listening on the loopback interface and serving on a thread of its own.
+         *
+         * @return bool Whether the port could be bound
+         */
+        bool start();
+
+        /**
+         * @brief Closes every connection and stops the serving thread.
+         */
+        void stop();
+
+        /**
+         * @brief Port the stand-in listens on, once started.
+         */
+        unsigned int port() const
+            { return bound_port; }
+
+        /**
+         * @brief Address the client library can be pointed at, "127.0.0.1:port".
+         */
+        std::string address() const;
+
+        stats statistics() const;
+
+    private:
+        typedef std::chrono::steady_clock clock;
+
+        struct file
+        {
+            // Contents followed by the trailing byte the real server sends along
+            std::string data;
+
+            // Compressed block of every chunk, built the first time a session asks for them
+            std::vector<std::string> blocks;
+        };
+
+        struct client
+        {
+            int               socket;
+            bool              compressed = false;
+
+            std::string       out;
+            std::size_t       sent = 0;
+            clock::time_point ready;
+            bool              close_after = false;
+        };
+
+        void run();
+
+        static bool pending(const client& c);
+
+        /**
+         * @brief Answers a command, queueing the reply on the client.
+         */
+        void handle(client& c, const std::string& command);
+
+        /**
+         * @brief Sends as much of the pending reply as the bandwidth allows.
+         *
+         * @return bool Whether the connection is still usable
+         */
+        bool flush(client& c, const clock::time_point now);
+
+        const std::vector<std::string>& blocks(file& f);
+
+        settings                              config;
+        std::unordered_map<std::string, file> files;
+
+        int                 listener;
+        unsigned int        bound_port;
+        std::thread         thread;
+        std::atomic<bool>   running;
+        std::mt19937        rng;
+
+        std::atomic<unsigned long long> connections, requests, chunks, bytes, dropped;
+    };
+}
@@ -0,0 +1,326 @@
+/**
+ * @file loadgen.cpp
+ *
+ * @brief Drives concurrent Cloud::get_file calls and reports how the client holds up.
+ *
+ * Usage: finapi_loadgen [options]
+ *
+ *   --concurrency n    Threads calling get_file at once (8)
+ *   --requests n       get_file calls in total (64)
+ *   --files n          Distinct files served (8)
+ *   --size bytes       Size of every file (1048576)
+ *   --workers n        Download executor threads, 0 keeps the default (0)
+ *   --pipelined        Ranged REQs, --depth n chunks each (64)
+ *   --compressed       Negotiate compressed chunk replies
+ *   --latency-us n     Stand-in holds back every reply (0)
+ *   --bandwidth mbps   Stand-in paces each connection to n MB/s, 0 for no limit (0)
+ *   --loss p           Share of chunk replies the stand-in cuts off (0)
+ *   --address ip:port  Use a running server instead of the stand-in, it has to serve
+ *                      load-0.bin ... load-<files - 1>.bin
+ *   --json             Print the results as one JSON object
+ *   --metrics          Print the client's metrics (see Metrics.h) after the results
+ *   --trace path       Record a timeline of every download (see Trace.h) as Chrome trace JSON
+ *   --check-ranges     Only check request_range against replies cut off part way, raw and
+ *                      compressed, and exit with 2 if any range was reported wrong
+ *
+ * Unless an address is given, the files are served by an in-process stand-in on a free
+ * loopback port (see StandIn.h), and every download is checked against what was served.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-28
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#include "StandIn.h"
+
+#include <iostream>
+#include <iomanip>
+
+using namespace finapi;
+
+namespace loadgen
+{
+    typedef std::chrono::steady_clock clock;
+
+    struct settings
+    {
+        unsigned int concurrency = 8;
+        unsigned int requests    = 64;
+        unsigned int files       = 8;
+        unsigned int size        = 1024 * 1024;
+        unsigned int workers     = 0;
+        bool         pipelined   = false;
+        unsigned int depth       = _FIN_PIPELINE_DEPTH;
+        bool         compressed  = false;
+        std::string  address;
+        std::string  trace;
+        bool         json        = false;
+        bool         metrics     = false;
+        bool         check       = false;
+
+        tools::StandIn::settings server;
+    };
+
+    /**
+     * @brief Threads of the process right now, zero where that can't be told.
+     */
+    static unsigned int thread_count()
+    {
+    #ifdef __linux__
+        std::error_code error;
+        unsigned int r = 0;
+        for (std::filesystem::directory_iterator it("/proc/self/task", error), end; !error && it != end; it.increment(error))
+            r++;
+        return r;
+    #else
+        return 0;
+    #endif
+    }
+
+    /**
+     * @brief Contents of a served file, text that compresses about as well as a filing.
+     */
+    static std::string make_file(c_uint size, c_uint seed)
+    {
+        static const char* words[] = { "Revenues", "Cost", "Operating", "Income", "Expense", "Assets",
+                                       "Liabilities", "Equity", "Net", "Tax", "Deferred", "Current" };
+
+        std::mt19937 rng(seed);
+        std::string r;
+        r.reserve(size + 32);
+
+        while (r.size() < size)
+        {
+            r += words[rng() % 12];
+            r += std::to_string(rng() % 100000);
+            r += ' ';
+        }
+
+        r.resize(size);
+        return r;
+    }
+
+    /**
+     * @brief Pulls ranges the stand-in cuts off at a random point and checks what request_range
+     *        reports: never more chunks than were asked for, and every chunk it counts intact.
+     *
+     * @return unsigned int Ranges that were reported wrong
+     */
+    static unsigned int check_partial_ranges(const bool compressed)
+    {
+        tools::StandIn::settings lossy;
+        lossy.loss = 1.0;
+
+        tools::StandIn server(lossy);
+        const std::string data = make_file(64 * _FIN_BUFFER_SIZE + 100, 99);
+        server.add_file("range.bin", data);
+        if (!server.start()) return 1;
+
+        const std::string address = server.address();
+        Cloud::options().compressed = compressed;
+
+        std::vector<char> buffer(data.size() + 1);
+        unsigned int wrong = 0;
+
+        for (int attempt = 0; attempt < 200; attempt++)
+        {
+            const int first = attempt % 16;
+            const int count = 48;
+
+            std::fill(buffer.begin(), buffer.end(), 0);
+
+            int completed = -1;
+            const Cloud::Status status = Cloud::request_range("range.bin", first, count, data.size(), buffer.data(), address.c_str(), &completed);
+
+            const std::size_t offset = (std::size_t)first * _FIN_BUFFER_SIZE;
+            if (status == Cloud::OK || completed < 0 || completed > count ||
+                std::memcmp(buffer.data() + offset, data.data() + offset, (std::size_t)completed * _FIN_BUFFER_SIZE))
+                wrong++;
+        }
+
+        server.stop();
+        return wrong;
+    }
+
+    static double percentile(const std::vector<double>& sorted, const double p)
+    {
+        if (sorted.empty()) return 0;
+        return sorted[std::min<std::size_t>(sorted.size() - 1, p * sorted.size())];
+    }
+
+    static bool parse(int argc, char** argv, settings& config)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+            const char* value = (i + 1 < argc ? argv[i + 1] : nullptr);
+
+            if (arg == "--pipelined")       config.pipelined  = true;
+            else if (arg == "--compressed") config.compressed = true;
+            else if (arg == "--json")       config.json       = true;
+            else if (arg == "--metrics")    config.metrics    = true;
+            else if (arg == "--check-ranges") config.check    = true;
+            else if (!value)                return false;
+            else
+            {
+                i++;
+                if (arg == "--concurrency")     config.concurrency       = std::max(1, std::atoi(value));
+                else if (arg == "--requests")   config.requests          = std::max(0, std::atoi(value));
+                else if (arg == "--files")      config.files             = std::max(1, std::atoi(value));
+                else if (arg == "--size")       config.size              = std::max(0, std::atoi(value));
+                else if (arg == "--workers")    config.workers           = std::max(0, std::atoi(value));
+                else if (arg == "--depth")      config.depth             = std::max(1, std::atoi(value));
+                else if (arg == "--latency-us") config.server.latency_us = std::max(0, std::atoi(value));
+                else if (arg == "--bandwidth")  config.server.bandwidth  = std::atof(value) * 1000 * 1000;
+                else if (arg == "--loss")       config.server.loss       = std::atof(value);
+                else if (arg == "--address")    config.address           = value;
+                else if (arg == "--trace")      config.trace             = value;
+                else return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    loadgen::settings config;
+    if (!loadgen::parse(argc, argv, config))
+    {
+        std::cerr << "usage: " << argv[0] << " [--concurrency n] [--requests n] [--files n] [--size bytes] [--workers n]"
+                  << " [--pipelined] [--depth n] [--compressed] [--latency-us n] [--bandwidth mbps] [--loss p]"
+                  << " [--address ip:port] [--json] [--metrics] [--trace path] [--check-ranges]\n";
+        return 1;
+    }
+
+    if (config.check)
+    {
+        const unsigned int raw    = loadgen::check_partial_ranges(false);
+        const unsigned int packed = loadgen::check_partial_ranges(true);
+
+        std::cout << "partial ranges: " << raw << " raw and " << packed << " compressed reported wrong\n";
+        return (raw || packed ? 2 : 0);
+    }
+
+    std::vector<std::string> names, contents;
+    for (unsigned int i = 0; i < config.files; i++)
+    {
+        names.push_back("load-" + std::to_string(i) + ".bin");
+        if (config.address.empty())
+            contents.push_back(loadgen::make_file(config.size, i + 1));
+    }
+
+    tools::StandIn server(config.server);
+    if (config.address.empty())
+    {
+        for (unsigned int i = 0; i < config.files; i++)
+            server.add_file(names[i], contents[i]);
+
+        if (!server.start())
+            { std::cerr << "the stand-in couldn't listen on the loopback interface\n"; return 1; }
+
+        config.address = server.address();
+    }
+
+    Cloud::options().pipelined      = config.pipelined;
+    Cloud::options().pipeline_depth = config.depth;
+    Cloud::options().compressed     = config.compressed;
+    if (config.workers) Cloud::set_download_workers(config.workers);
+    if (!config.trace.empty()) trace::start();
+
+    // Everything started from here on is the client's doing, the callers are gone again
+    // by the time the count is taken
+    const unsigned int threads_before = loadgen::thread_count();
+
+    std::vector<double> latencies(config.requests);
+    std::atomic<unsigned int> next(0);
+    std::atomic<unsigned long long> received(0);
+    std::atomic<unsigned int> failed(0), corrupt(0);
+
+    const loadgen::clock::time_point start = loadgen::clock::now();
+
+    std::vector<std::thread> callers;
+    for (unsigned int t = 0; t < config.concurrency; t++)
+    {
+        callers.emplace_back([&]()
+        {
+            for (unsigned int i; (i = next++) < config.requests;)
+            {
+                const unsigned int f = i % config.files;
+
+                const loadgen::clock::time_point begin = loadgen::clock::now();
+                Cloud::File* file;
+                Cloud::get_file(names[f].c_str(), config.address.c_str(), file);
+                latencies[i] = std::chrono::duration<double, std::milli>(loadgen::clock::now() - begin).count();
+
+                if (file->status != Cloud::OK)
+                    failed++;
+                else
+                {
+                    received += file->filesize;
+                    if (!contents.empty() && (file->filesize != contents[f].size() || std::memcmp(file->buffer, contents[f].data(), file->filesize)))
+                        corrupt++;
+                }
+
+                delete file;
+            }
+        });
+    }
+
+    for (std::thread& caller : callers)
+        caller.join();
+
+    const double seconds = std::chrono::duration<double>(loadgen::clock::now() - start).count();
+    const unsigned int threads = loadgen::thread_count() - threads_before;
+
+    std::sort(latencies.begin(), latencies.end());
+    const double p50  = loadgen::percentile(latencies, 0.5);
+    const double p99  = loadgen::percentile(latencies, 0.99);
+    const double p999 = loadgen::percentile(latencies, 0.999);
+    const double mbps = received / seconds / (1000 * 1000);
+
+    const tools::StandIn::stats served = server.statistics();
+    server.stop();
+
+    // Connections are only known when the stand-in accepted them
+    const long long sockets = (contents.empty() ? -1 : (long long)served.connections);
+
+    if (config.json)
+    {
+        std::cout << std::fixed << std::setprecision(4)
+                  << "{\"requests\":" << config.requests << ",\"concurrency\":" << config.concurrency
+                  << ",\"size\":" << config.size << ",\"pipelined\":" << (config.pipelined ? "true" : "false")
+                  << ",\"compressed\":" << (config.compressed ? "true" : "false")
+                  << ",\"latency_us\":" << config.server.latency_us << ",\"bandwidth\":" << config.server.bandwidth
+                  << ",\"loss\":" << config.server.loss
+                  << ",\"seconds\":" << seconds << ",\"p50_ms\":" << p50 << ",\"p99_ms\":" << p99 << ",\"p999_ms\":" << p999
+                  << ",\"mb_per_s\":" << mbps << ",\"failed\":" << failed << ",\"corrupt\":" << corrupt
+                  << ",\"sockets\":" << sockets << ",\"threads\":" << threads
+                  << ",\"chunk_requests\":" << served.requests << ",\"dropped\":" << served.dropped << "}\n";
+    }
+    else
+    {
+        std::cout << std::fixed << std::setprecision(2)
+                  << config.requests << " get_file calls, " << config.concurrency << " at once, "
+                  << config.size / 1024 << " KiB each, " << seconds << " s\n"
+                  << "latency   p50 " << p50 << " ms, p99 " << p99 << " ms, p999 " << p999 << " ms\n"
+                  << "transfer  " << mbps << " MB/s, " << failed << " failed, " << corrupt << " corrupt\n"
+                  << "client    " << sockets << " sockets opened, " << threads << " threads spawned\n";
+
+        if (sockets >= 0)
+            std::cout << "stand-in  " << served.requests << " chunk requests, " << served.chunks << " chunks, "
+                      << served.dropped << " dropped\n";
+    }
+
+    if (config.metrics)
+        std::cout << metrics::expose();
+
+    if (!config.trace.empty() && !trace::write_chrome(config.trace.c_str()))
+        std::cerr << "couldn't write " << config.trace << "\n";
+
+    return (failed || corrupt ? 2 : 0);
+}
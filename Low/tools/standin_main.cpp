@@ -0,0 +1,63 @@
+/**
+ * @file standin_main.cpp
+ *
+ * @brief Serves the files of a directory through the stand-in server, for pointing any
+ *        client at it by hand.
+ *
+ * Usage: finapi_standin <directory> [--port n] [--latency-us n] [--bandwidth mbps] [--loss p]
+ *
+ * The port defaults to the one of the real server. Runs until it is interrupted.
+ *
+ * @author  Max Ortner
+ * @date    2020-01-28
+ * @version 0.1
+ *
+ * @copyright Copyright (c) 2020
+ *
+ */
+
+#include "StandIn.h"
+
+#include <iostream>
+#include <iterator>
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <directory> [--port n] [--latency-us n] [--bandwidth mbps] [--loss p]\n";
+        return 1;
+    }
+
+    tools::StandIn::settings config;
+    config.port = _FIN_PORT;
+
+    for (int i = 2; i + 1 < argc; i += 2)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--port")            config.port       = std::atoi(argv[i + 1]);
+        else if (arg == "--latency-us") config.latency_us = std::atoi(argv[i + 1]);
+        else if (arg == "--bandwidth")  config.bandwidth  = std::atof(argv[i + 1]) * 1000 * 1000;
+        else if (arg == "--loss")       config.loss       = std::atof(argv[i + 1]);
+    }
+
+    tools::StandIn server(config);
+
+    unsigned int served = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(argv[1]))
+    {
+        if (!entry.is_regular_file()) continue;
+
+        std::ifstream in(entry.path(), std::ios::binary);
+        server.add_file(entry.path().filename().string(), std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()));
+        served++;
+    }
+
+    if (!server.start())
+        { std::cerr << "couldn't listen on port " << config.port << "\n"; return 1; }
+
+    std::cout << "serving " << served << " files on " << server.address() << "\n";
+
+    for (;;)
+        std::this_thread::sleep_for(std::chrono::seconds(60));
+}